@@ -0,0 +1,164 @@
+// Compares stepping a world on one thread and on four (b2World::SetThreadCount).
+//
+// Each scene is stepped once per thread count from the same initial state.
+// Times are for whole steps. The same column checks that both runs end with
+// identical body positions and awake states and saw the same sequence of
+// begin and end contact callbacks, which the world promises for any thread
+// count.
+
+#include <Box2D/Box2D.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+typedef void (*Scene)(b2World*);
+typedef void (*Event)(b2World*, int step);
+
+// Folds every begin and end contact callback, in order, into one value.
+class Events : public b2ContactListener
+{
+public:
+  Events() : hash(0) {}
+
+  void BeginContact(b2Contact* contact) { add(contact, 1); }
+  void EndContact(b2Contact* contact) { add(contact, 2); }
+
+  unsigned long hash;
+
+private:
+  void add(b2Contact* contact, unsigned long kind)
+  {
+    unsigned long a = (unsigned long) contact->GetFixtureA()->GetBody()->GetUserData();
+    unsigned long b = (unsigned long) contact->GetFixtureB()->GetBody()->GetUserData();
+    hash = ((hash * 31 + kind) * 31 + a) * 31 + b;
+  }
+};
+
+static b2Body* createBox(b2World* world, float x, float y)
+{
+  b2BodyDef def;
+  def.type = b2_dynamicBody;
+  def.position.Set(x, y);
+  b2PolygonShape box;
+  box.SetAsBox(0.5f, 0.5f);
+  b2Body* body = world->CreateBody(&def);
+  body->CreateFixture(&box, 1);
+  return body;
+}
+
+static void createGround(b2World* world)
+{
+  b2BodyDef def;
+  b2EdgeShape edge;
+  edge.Set(b2Vec2(-2000, 0), b2Vec2(2000, 0));
+  world->CreateBody(&def)->CreateFixture(&edge, 0);
+}
+
+// 20 pyramids of 10 rows, 1100 boxes in separate islands on the same ground.
+static void pyramids(b2World* world)
+{
+  createGround(world);
+  for (int p = 0; p < 20; p++)
+    for (int row = 0; row < 10; row++)
+      for (int col = 0; col < 10 - row; col++)
+        createBox(world, p * 20 - 400 + col + row * 0.5f, 0.5f + row);
+}
+
+// 100 rows of 4 boxes that fall asleep, each approached by a kinematic
+// pusher. Before it arrives, one box of each row is moved, which leaves it
+// asleep, so contacts of sleeping bodies are woken during the narrow-phase.
+static void woken(b2World* world)
+{
+  createGround(world);
+  for (int r = 0; r < 100; r++)
+  {
+    for (int i = 0; i < 4; i++)
+      createBox(world, r * 30 - 1500 + i, 0.5f);
+
+    b2BodyDef def;
+    def.type = b2_kinematicBody;
+    def.position.Set(r * 30 - 1508 - (r % 10) * 0.3f, 0.5f);
+    def.linearVelocity.Set(1, 0);
+    b2PolygonShape pusher;
+    pusher.SetAsBox(0.5f, 0.4f);
+    world->CreateBody(&def)->CreateFixture(&pusher, 0);
+  }
+}
+
+static void moveSleepingBoxes(b2World* world, int step)
+{
+  if (step != 200)
+    return;
+
+  int i = 0;
+  for (b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+  {
+    if (body->GetType() == b2_dynamicBody && i++ % 4 == 1)
+      body->SetTransform(body->GetPosition() + b2Vec2(0.05f, 0.3f), 0.1f);
+  }
+}
+
+struct Result
+{
+  float time;
+  unsigned long events;
+  std::vector<b2Vec2> positions;
+  std::vector<bool> awake;
+};
+
+static void run(Scene scene, Event event, bool sleep, int threads, int steps, Result* result)
+{
+  b2World world(b2Vec2(0, -10));
+  Events events;
+  world.SetContactListener(&events);
+  world.SetAllowSleeping(sleep);
+  world.SetThreadCount(threads);
+  scene(&world);
+
+  unsigned long id = 0;
+  for (b2Body* body = world.GetBodyList(); body; body = body->GetNext())
+    body->SetUserData((void*) ++id);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < steps; i++)
+  {
+    if (event)
+      event(&world, i);
+    world.Step(1.0f / 60.0f, 8, 3);
+  }
+  std::chrono::duration<float, std::milli> time = std::chrono::steady_clock::now() - start;
+
+  result->time = time.count();
+  result->events = events.hash;
+  result->positions.clear();
+  result->awake.clear();
+  for (b2Body* body = world.GetBodyList(); body; body = body->GetNext())
+  {
+    result->positions.push_back(body->GetPosition());
+    result->awake.push_back(body->IsAwake());
+  }
+}
+
+static bool compare(const char* name, Scene scene, Event event, bool sleep, int steps)
+{
+  Result serial, parallel;
+  run(scene, event, sleep, 1, steps, &serial);
+  run(scene, event, sleep, 4, steps, &parallel);
+
+  bool same = serial.events == parallel.events && serial.awake == parallel.awake;
+  for (size_t i = 0; i < serial.positions.size(); i++)
+    same = same && serial.positions[i].x == parallel.positions[i].x && serial.positions[i].y == parallel.positions[i].y;
+
+  printf("%-10s %12.1f %12.1f %8.2fx %6s\n", name, serial.time, parallel.time, serial.time / parallel.time,
+    same ? "yes" : "NO");
+  return same;
+}
+
+int main()
+{
+  printf("%-10s %12s %12s %9s %6s\n", "scene", "1 thread ms", "4 threads ms", "speedup", "same");
+
+  bool same = compare("pyramids", pyramids, NULL, false, 120);
+  same = compare("woken", woken, moveSleepingBoxes, true, 700) && same;
+  return same ? 0 : 1;
+}
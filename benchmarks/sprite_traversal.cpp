@@ -0,0 +1,153 @@
+// Measures the interpreter heap a sprite tree takes and how fast it is walked,
+// for comparing the mruby builds in benchmarks/CMakeLists.txt.
+//
+// Sprites are built the way the engine builds them: data objects with their
+// children in an array kept as the "children" property and their listeners in
+// a hash, and they are walked the way Sprite::render walks them, looking the
+// children up and unwrapping each child every time.
+
+#include <mruby.h>
+#include <mruby/array.h>
+#include <mruby/class.h>
+#include <mruby/data.h>
+#include <mruby/hash.h>
+#include <mruby/variable.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+struct Node
+{
+  float x;
+  float y;
+};
+
+static const mrb_data_type NodeType = { "Node", mrb_free };
+
+// Counts the bytes the interpreter holds, each block prefixed with its size.
+struct Usage
+{
+  size_t bytes;
+  size_t peak;
+};
+
+static const size_t HEADER = 16;
+
+static void* countingAlloc(mrb_state* mrb, void* p, size_t size, void* ud)
+{
+  Usage* usage = (Usage*) ud;
+  if (p)
+  {
+    p = (char*) p - HEADER;
+    usage->bytes -= *(size_t*) p;
+  }
+  if (size == 0)
+  {
+    free(p);
+    return NULL;
+  }
+
+  p = realloc(p, size + HEADER);
+  if (!p) return NULL;
+  *(size_t*) p = size;
+  usage->bytes += size;
+  if (usage->bytes > usage->peak) usage->peak = usage->bytes;
+  return (char*) p + HEADER;
+}
+
+static mrb_value build(mrb_state* mrb, struct RClass* sprite, int depth, int fanout)
+{
+  Node* node = (Node*) mrb_malloc(mrb, sizeof(Node));
+  node->x = depth;
+  node->y = fanout;
+  mrb_value self = mrb_obj_value(mrb_data_object_alloc(mrb, sprite, node, &NodeType));
+
+  mrb_value children = mrb_ary_new(mrb);
+  mrb_iv_set(mrb, self, mrb_intern(mrb, "children"), children);
+  mrb_iv_set(mrb, self, mrb_intern(mrb, "listeners"), mrb_hash_new(mrb));
+
+  if (depth > 0)
+  {
+    int arena = mrb_gc_arena_save(mrb);
+    for (int i = 0; i < fanout; i++)
+    {
+      mrb_ary_push(mrb, children, build(mrb, sprite, depth - 1, fanout));
+      mrb_gc_arena_restore(mrb, arena);
+    }
+  }
+  return self;
+}
+
+static float traverse(mrb_state* mrb, mrb_value self)
+{
+  Node* node = (Node*) DATA_PTR(self);
+  float sum = node->x + node->y;
+
+  mrb_value children = mrb_iv_get(mrb, self, mrb_intern(mrb, "children"));
+  for (int i = 0; i < RARRAY_LEN(children); i++)
+  {
+    sum += traverse(mrb, mrb_ary_ref(mrb, children, i));
+  }
+  return sum;
+}
+
+static void run(int depth, int fanout, int passes)
+{
+  Usage usage = { 0, 0 };
+  mrb_state* mrb = mrb_open_allocf(countingAlloc, &usage);
+  struct RClass* sprite = mrb_define_class(mrb, "Sprite", mrb->object_class);
+  MRB_SET_INSTANCE_TT(sprite, MRB_TT_DATA);
+
+  mrb_full_gc(mrb);
+  size_t baseline = usage.bytes;
+  size_t live = mrb->live;
+
+  mrb_gv_set(mrb, mrb_intern(mrb, "$root"), build(mrb, sprite, depth, fanout));
+  mrb_full_gc(mrb);
+  size_t bytes = usage.bytes - baseline;
+  size_t objects = mrb->live - live;
+  size_t sprites = 0;
+  for (size_t level = 1, i = 0; i <= (size_t) depth; i++, level *= fanout)
+    sprites += level;
+
+  volatile float sum = 0;
+  mrb_value root = mrb_gv_get(mrb, mrb_intern(mrb, "$root"));
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < passes; i++)
+    sum += traverse(mrb, root);
+  std::chrono::duration<float, std::milli> time = std::chrono::steady_clock::now() - start;
+
+  printf("%8lu %10lu %10.1f %10.1f %12.1f\n", (unsigned long) sprites, (unsigned long) objects, bytes / 1024.0f,
+    (float) bytes / sprites, time.count() * 1e6f / (passes * sprites));
+
+  mrb_close(mrb);
+}
+
+int main()
+{
+#if defined(MRB_NAN_BOXING)
+  const char* boxing = "nan";
+#elif defined(MRB_WORD_BOXING)
+  const char* boxing = "word";
+#else
+  const char* boxing = "none";
+#endif
+#ifdef MRB_USE_IV_SEGLIST
+  const char* ivars = "seglist";
+#else
+  const char* ivars = "khash";
+#endif
+#ifdef MRB_HEAP_PAGE_SIZE
+  int pageSize = MRB_HEAP_PAGE_SIZE;
+#else
+  int pageSize = 1024;
+#endif
+
+  printf("boxing: %s, mrb_value: %lu bytes, heap page: %d objects, ivars: %s\n", boxing,
+    (unsigned long) sizeof(mrb_value), pageSize, ivars);
+  printf("%8s %10s %10s %10s %12s\n", "sprites", "objects", "heap KB", "B/sprite", "ns/sprite");
+  run(3, 8, 2000);
+  run(4, 8, 200);
+  run(5, 8, 20);
+  return 0;
+}
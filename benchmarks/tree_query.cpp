@@ -0,0 +1,113 @@
+// Compares AABB queries and ray casts against a dynamic tree before and after
+// it is compacted.
+//
+// The same queries and rays are run against both layouts. The proxies each
+// reports are compared in order, since compaction must not change it.
+
+#include <Box2D/Box2D.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+struct QueryCollector
+{
+  std::vector<int32> proxies;
+
+  bool QueryCallback(int32 proxyId)
+  {
+    proxies.push_back(proxyId);
+    return true;
+  }
+};
+
+// Clips the ray to every other proxy hit, like a closest-hit callback would.
+struct RayCastCollector
+{
+  std::vector<int32> proxies;
+
+  float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+  {
+    proxies.push_back(proxyId);
+    return proxyId % 2 ? input.maxFraction * 0.9f : input.maxFraction;
+  }
+};
+
+static float random(float low, float high)
+{
+  return low + (high - low) * rand() / (float) RAND_MAX;
+}
+
+static b2AABB bounds(const b2Vec2& position, float extent)
+{
+  b2AABB aabb;
+  aabb.lowerBound = position - b2Vec2(extent, extent);
+  aabb.upperBound = position + b2Vec2(extent, extent);
+  return aabb;
+}
+
+// Runs the queries and rays, returning the time taken in milliseconds for each.
+static void run(const b2DynamicTree& tree, const std::vector<b2AABB>& queries, const std::vector<b2RayCastInput>& rays,
+  QueryCollector* queried, RayCastCollector* cast, float* queryTime, float* rayTime)
+{
+  b2Timer queryTimer;
+  for (size_t i = 0; i < queries.size(); i++)
+    tree.Query(queried, queries[i]);
+  *queryTime = queryTimer.GetMilliseconds();
+
+  b2Timer rayTimer;
+  for (size_t i = 0; i < rays.size(); i++)
+    tree.RayCast(cast, rays[i]);
+  *rayTime = rayTimer.GetMilliseconds();
+}
+
+static void compare(int count, float size, int samples)
+{
+  srand(42);
+  b2DynamicTree tree;
+  for (int i = 0; i < count; i++)
+  {
+    b2Vec2 position(random(0, size), random(0, size));
+    int32 proxyId = tree.CreateProxy(bounds(position, random(0.2f, 1)), NULL);
+
+    // Shuffle the tree around so nodes are not allocated in tree order.
+    if (i % 3 == 0)
+      tree.MoveProxy(proxyId, bounds(position + b2Vec2(5, 5), 0.5f), b2Vec2(5, 5));
+  }
+
+  std::vector<b2AABB> queries(samples);
+  std::vector<b2RayCastInput> rays(samples);
+  for (int i = 0; i < samples; i++)
+  {
+    queries[i] = bounds(b2Vec2(random(0, size), random(0, size)), random(1, 5));
+    rays[i].p1.Set(random(0, size), random(0, size));
+    rays[i].p2 = rays[i].p1 + b2Vec2(random(-50, 50), random(-50, 50));
+    rays[i].maxFraction = 1;
+  }
+
+  QueryCollector treeQueried, compactQueried;
+  RayCastCollector treeCast, compactCast;
+  float treeQueryTime, treeRayTime, compactQueryTime, compactRayTime;
+
+  run(tree, queries, rays, &treeQueried, &treeCast, &treeQueryTime, &treeRayTime);
+
+  b2Timer compactTimer;
+  tree.Compact();
+  float compactTime = compactTimer.GetMilliseconds();
+
+  run(tree, queries, rays, &compactQueried, &compactCast, &compactQueryTime, &compactRayTime);
+
+  bool same = treeQueried.proxies == compactQueried.proxies && treeCast.proxies == compactCast.proxies;
+  printf("%8d %8.2f %10.1f %10.1f %8.2fx %10.1f %10.1f %8.2fx %s\n", count, compactTime,
+    treeQueryTime, compactQueryTime, treeQueryTime / compactQueryTime,
+    treeRayTime, compactRayTime, treeRayTime / compactRayTime, same ? "yes" : "NO");
+}
+
+int main()
+{
+  printf("%8s %8s %10s %10s %9s %10s %10s %9s %s\n", "proxies", "compact", "query ms", "compact ms", "speedup",
+    "ray ms", "compact ms", "speedup", "same hits");
+  compare(1000, 100, 20000);
+  compare(10000, 300, 20000);
+  compare(100000, 1000, 20000);
+  return 0;
+}
@@ -29,10 +29,17 @@ b2BroadPhase::b2BroadPhase()
 	m_moveCapacity = 16;
 	m_moveCount = 0;
 	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+
+	m_movedCapacity = 16;
+	m_moved = (bool*)b2Alloc(m_movedCapacity * sizeof(bool));
+	memset(m_moved, 0, m_movedCapacity * sizeof(bool));
+
+	m_pairMode = e_sortedPairs;
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
+	b2Free(m_moved);
 	b2Free(m_moveBuffer);
 	b2Free(m_pairBuffer);
 }
@@ -66,8 +73,31 @@ void b2BroadPhase::TouchProxy(int32 proxyId)
 	BufferMove(proxyId);
 }
 
+void b2BroadPhase::SetPairMode(PairMode mode)
+{
+	m_pairMode = mode;
+}
+
 void b2BroadPhase::BufferMove(int32 proxyId)
 {
+	// A proxy only needs to be queried once per update.
+	if (WasMoved(proxyId))
+	{
+		return;
+	}
+
+	if (proxyId >= m_movedCapacity)
+	{
+		bool* oldMoved = m_moved;
+		int32 oldCapacity = m_movedCapacity;
+		m_movedCapacity = b2Max(2 * m_movedCapacity, proxyId + 1);
+		m_moved = (bool*)b2Alloc(m_movedCapacity * sizeof(bool));
+		memcpy(m_moved, oldMoved, oldCapacity * sizeof(bool));
+		memset(m_moved + oldCapacity, 0, (m_movedCapacity - oldCapacity) * sizeof(bool));
+		b2Free(oldMoved);
+	}
+	m_moved[proxyId] = true;
+
 	if (m_moveCount == m_moveCapacity)
 	{
 		int32* oldBuffer = m_moveBuffer;
@@ -83,6 +113,12 @@ void b2BroadPhase::BufferMove(int32 proxyId)
 
 void b2BroadPhase::UnBufferMove(int32 proxyId)
 {
+	if (WasMoved(proxyId) == false)
+	{
+		return;
+	}
+	m_moved[proxyId] = false;
+
 	for (int32 i = 0; i < m_moveCount; ++i)
 	{
 		if (m_moveBuffer[i] == proxyId)
@@ -101,6 +137,13 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 		return true;
 	}
 
+	// When both proxies moved, the pair is found by both queries. Keep the
+	// one from the proxy with the higher id.
+	if (m_pairMode == e_uniquePairs && proxyId > m_queryProxyId && WasMoved(proxyId))
+	{
+		return true;
+	}
+
 	// Grow the pair buffer as needed.
 	if (m_pairCount == m_pairCapacity)
 	{
@@ -117,3 +160,72 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 
 	return true;
 }
+
+// State layout: the tree, the move count and the move buffer.
+int32 b2BroadPhase::GetStateSize() const
+{
+	return m_tree.GetStateSize() + (1 + m_moveCount) * sizeof(int32);
+}
+
+void b2BroadPhase::SaveState(void* state) const
+{
+	m_tree.SaveState(state);
+	int32* moves = (int32*)((char*)state + m_tree.GetStateSize());
+	moves[0] = m_moveCount;
+	memcpy(moves + 1, m_moveBuffer, m_moveCount * sizeof(int32));
+}
+
+bool b2BroadPhase::LoadState(const void* state, int32 size)
+{
+	int32 treeSize = m_tree.GetStateSize();
+	int32 moveCount;
+	if (size < treeSize + (int32)sizeof(int32))
+	{
+		return false;
+	}
+
+	// The moves are checked against the current proxies, which the tree
+	// state must leave as they are.
+	const char* moves = (const char*)state + treeSize;
+	memcpy(&moveCount, moves, sizeof(int32));
+	moves += sizeof(int32);
+	if ((size - treeSize) % sizeof(int32) != 0 || moveCount != (size - treeSize) / (int32)sizeof(int32) - 1)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < moveCount; ++i)
+	{
+		int32 proxyId;
+		memcpy(&proxyId, moves + i * sizeof(int32), sizeof(int32));
+		if (proxyId != e_nullProxy && m_tree.IsProxy(proxyId) == false)
+		{
+			return false;
+		}
+	}
+
+	if (m_tree.LoadState(state, treeSize) == false)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		if (m_moveBuffer[i] != e_nullProxy)
+		{
+			m_moved[m_moveBuffer[i]] = false;
+		}
+	}
+	m_moveCount = 0;
+
+	for (int32 i = 0; i < moveCount; ++i)
+	{
+		int32 proxyId;
+		memcpy(&proxyId, moves + i * sizeof(int32), sizeof(int32));
+		if (proxyId != e_nullProxy)
+		{
+			BufferMove(proxyId);
+		}
+	}
+	return true;
+}
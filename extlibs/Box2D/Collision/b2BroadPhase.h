@@ -42,6 +42,19 @@ public:
 		e_nullProxy = -1
 	};
 
+	/// How UpdatePairs avoids reporting a pair twice.
+	enum PairMode
+	{
+		/// Gather the pairs of every moved proxy, sort them and skip
+		/// duplicates. Pairs are reported in proxy id order. This is the default.
+		e_sortedPairs,
+
+		/// When both proxies of a pair moved, only the query of the one with
+		/// the higher id reports it, so no duplicates are produced and nothing
+		/// needs sorting. Pairs are reported in query order.
+		e_uniquePairs
+	};
+
 	b2BroadPhase();
 	~b2BroadPhase();
 
@@ -71,6 +84,10 @@ public:
 	/// Get the number of proxies.
 	int32 GetProxyCount() const;
 
+	/// Select how duplicate pairs are avoided. Both modes report the same pairs.
+	void SetPairMode(PairMode mode);
+	PairMode GetPairMode() const;
+
 	/// Update the pairs. This results in pair callbacks. This can only add pairs.
 	template <typename T>
 	void UpdatePairs(T* callback);
@@ -104,6 +121,24 @@ public:
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Compact the embedded tree for faster queries and ray casts. It stays
+	/// compact until a proxy is created, moved or destroyed.
+	void Compact();
+
+	/// Get the size in bytes of the state written by SaveState.
+	int32 GetStateSize() const;
+
+	/// Copy the tree and the buffered moves into state.
+	void SaveState(void* state) const;
+
+	/// Load a state of size bytes written by SaveState. Returns false, leaving
+	/// the broad-phase untouched, if proxies were created or destroyed since
+	/// or the state is damaged.
+	bool LoadState(const void* state, int32 size);
+
+	/// Is this the id of a proxy of the broad-phase?
+	bool IsProxy(int32 proxyId) const;
+
 private:
 
 	friend class b2DynamicTree;
@@ -113,6 +148,8 @@ private:
 
 	bool QueryCallback(int32 proxyId);
 
+	bool WasMoved(int32 proxyId) const;
+
 	b2DynamicTree m_tree;
 
 	int32 m_proxyCount;
@@ -121,6 +158,12 @@ private:
 	int32 m_moveCapacity;
 	int32 m_moveCount;
 
+	// Flags the proxies in the move buffer, indexed by proxy id.
+	bool* m_moved;
+	int32 m_movedCapacity;
+
+	PairMode m_pairMode;
+
 	b2Pair* m_pairBuffer;
 	int32 m_pairCapacity;
 	int32 m_pairCount;
@@ -144,6 +187,11 @@ inline bool b2PairLessThan(const b2Pair& pair1, const b2Pair& pair2)
 	return false;
 }
 
+inline bool b2BroadPhase::IsProxy(int32 proxyId) const
+{
+	return m_tree.IsProxy(proxyId);
+}
+
 inline void* b2BroadPhase::GetUserData(int32 proxyId) const
 {
 	return m_tree.GetUserData(proxyId);
@@ -166,6 +214,21 @@ inline int32 b2BroadPhase::GetProxyCount() const
 	return m_proxyCount;
 }
 
+inline void b2BroadPhase::Compact()
+{
+	m_tree.Compact();
+}
+
+inline b2BroadPhase::PairMode b2BroadPhase::GetPairMode() const
+{
+	return m_pairMode;
+}
+
+inline bool b2BroadPhase::WasMoved(int32 proxyId) const
+{
+	return proxyId < m_movedCapacity && m_moved[proxyId];
+}
+
 inline int32 b2BroadPhase::GetTreeHeight() const
 {
 	return m_tree.GetHeight();
@@ -205,8 +268,27 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	}
 
 	// Reset move buffer
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		if (m_moveBuffer[i] != e_nullProxy)
+		{
+			m_moved[m_moveBuffer[i]] = false;
+		}
+	}
 	m_moveCount = 0;
 
+	if (m_pairMode == e_uniquePairs)
+	{
+		// Every pair is already unique.
+		for (int32 i = 0; i < m_pairCount; ++i)
+		{
+			void* userDataA = m_tree.GetUserData(m_pairBuffer[i].proxyIdA);
+			void* userDataB = m_tree.GetUserData(m_pairBuffer[i].proxyIdB);
+			callback->AddPair(userDataA, userDataB);
+		}
+		return;
+	}
+
 	// Sort the pair buffer to expose duplicates.
 	std::sort(m_pairBuffer, m_pairBuffer + m_pairCount, b2PairLessThan);
 
@@ -41,12 +41,18 @@ b2DynamicTree::b2DynamicTree()
 	m_path = 0;
 
 	m_insertionCount = 0;
+
+	m_compactNodes = NULL;
+	m_compactCapacity = 0;
+	m_compactRoot = -1;
+	m_compactValid = false;
 }
 
 b2DynamicTree::~b2DynamicTree()
 {
 	// This frees the entire tree in one shot.
 	b2Free(m_nodes);
+	b2Free(m_compactNodes);
 }
 
 // Allocate a node from the pool. Grow the pool if necessary.
@@ -175,6 +181,8 @@ bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& d
 
 void b2DynamicTree::InsertLeaf(int32 leaf)
 {
+	m_compactValid = false;
+
 	++m_insertionCount;
 
 	if (m_root == b2_nullNode)
@@ -315,6 +323,8 @@ void b2DynamicTree::InsertLeaf(int32 leaf)
 
 void b2DynamicTree::RemoveLeaf(int32 leaf)
 {
+	m_compactValid = false;
+
 	if (leaf == m_root)
 	{
 		m_root = b2_nullNode;
@@ -693,6 +703,8 @@ int32 b2DynamicTree::GetMaxBalance() const
 
 void b2DynamicTree::RebuildBottomUp()
 {
+	m_compactValid = false;
+
 	int32* nodes = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
 	int32 count = 0;
 
@@ -769,6 +781,8 @@ void b2DynamicTree::RebuildBottomUp()
 
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
+	m_compactValid = false;
+
 	// Build array of leaves. Free the rest.
 	for (int32 i = 0; i < m_nodeCapacity; ++i)
 	{
@@ -776,3 +790,209 @@ void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 		m_nodes[i].aabb.upperBound -= newOrigin;
 	}
 }
+
+void b2DynamicTree::Compact()
+{
+	if (m_compactValid)
+	{
+		return;
+	}
+
+	m_compactValid = true;
+	m_compactRoot = -1;
+
+	if (m_root == b2_nullNode || m_nodes[m_root].IsLeaf())
+	{
+		return;
+	}
+
+	// A binary tree with n leaves has n - 1 internal nodes.
+	int32 count = (m_nodeCount - 1) / 2;
+	if (count > m_compactCapacity)
+	{
+		b2Free(m_compactNodes);
+		m_compactCapacity = count;
+		m_compactNodes = (b2CompactNode*)b2Alloc(m_compactCapacity * sizeof(b2CompactNode));
+	}
+
+	// Depth first, child1 first, so a query descending into child1 reads the
+	// next node in memory. Each entry holds the compacted slot to fill in.
+	b2GrowableStack<int32, 256> stack;
+	b2GrowableStack<int32*, 256> slots;
+	int32 next = 0;
+
+	stack.Push(m_root);
+	slots.Push(&m_compactRoot);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeId = stack.Pop();
+		int32* slot = slots.Pop();
+		const b2TreeNode* node = m_nodes + nodeId;
+
+		if (node->IsLeaf())
+		{
+			*slot = ~nodeId;
+			continue;
+		}
+
+		b2Assert(next < count);
+		int32 index = next++;
+		*slot = index;
+
+		b2CompactNode* compact = m_compactNodes + index;
+		const b2AABB& aabb1 = m_nodes[node->child1].aabb;
+		const b2AABB& aabb2 = m_nodes[node->child2].aabb;
+		compact->lower[0] = aabb1.lowerBound.x;
+		compact->lower[1] = aabb2.lowerBound.x;
+		compact->lower[2] = aabb1.lowerBound.y;
+		compact->lower[3] = aabb2.lowerBound.y;
+		compact->upper[0] = aabb1.upperBound.x;
+		compact->upper[1] = aabb2.upperBound.x;
+		compact->upper[2] = aabb1.upperBound.y;
+		compact->upper[3] = aabb2.upperBound.y;
+
+		// Pushed in reverse so child1 is taken first.
+		stack.Push(node->child2);
+		slots.Push(compact->children + 1);
+		stack.Push(node->child1);
+		slots.Push(compact->children + 0);
+	}
+
+	b2Assert(next == count);
+}
+
+// State layout: the root, node count, node capacity, free list, path and
+// insertion count, followed by every node.
+const int32 b2_treeStateHeaderSize = 6 * sizeof(int32);
+
+int32 b2DynamicTree::GetStateSize() const
+{
+	return b2_treeStateHeaderSize + m_nodeCapacity * sizeof(b2TreeNode);
+}
+
+void b2DynamicTree::SaveState(void* state) const
+{
+	int32* header = (int32*)state;
+	header[0] = m_root;
+	header[1] = m_nodeCount;
+	header[2] = m_nodeCapacity;
+	header[3] = m_freeList;
+	header[4] = (int32)m_path;
+	header[5] = m_insertionCount;
+	memcpy((char*)state + b2_treeStateHeaderSize, m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
+}
+
+// States are not aligned, so their nodes are copied out to be read.
+static inline b2TreeNode b2ReadTreeNode(const char* nodes, int32 index)
+{
+	b2TreeNode node;
+	memcpy(&node, nodes + index * sizeof(b2TreeNode), sizeof(b2TreeNode));
+	return node;
+}
+
+bool b2DynamicTree::LoadState(const void* state, int32 size)
+{
+	if (size != GetStateSize())
+	{
+		return false;
+	}
+
+	int32 header[b2_treeStateHeaderSize / sizeof(int32)];
+	memcpy(header, state, sizeof(header));
+	int32 root = header[0];
+	int32 nodeCount = header[1];
+	int32 freeList = header[3];
+	if (header[2] != m_nodeCapacity || nodeCount < 0 || nodeCount > m_nodeCapacity ||
+		root < b2_nullNode || root >= m_nodeCapacity || freeList < b2_nullNode || freeList >= m_nodeCapacity)
+	{
+		return false;
+	}
+
+	// Check every node on its own. The user data of the leaves is compared,
+	// never followed.
+	const char* nodes = (const char*)state + b2_treeStateHeaderSize;
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		b2TreeNode node = b2ReadTreeNode(nodes, i);
+		bool leaf = node.height == 0;
+		if (leaf != (m_nodes[i].height == 0) || node.height < -1)
+		{
+			return false;
+		}
+
+		if (leaf && (node.userData != m_nodes[i].userData || node.child1 != b2_nullNode || node.child2 != b2_nullNode))
+		{
+			return false;
+		}
+
+		if (node.height > 0 && (node.child1 < 0 || node.child1 >= m_nodeCapacity ||
+			node.child2 < 0 || node.child2 >= m_nodeCapacity || node.child1 == node.child2))
+		{
+			return false;
+		}
+
+		if (node.parent < b2_nullNode || node.parent >= m_nodeCapacity)
+		{
+			return false;
+		}
+	}
+
+	// The nodes in use must hang from the root, each reached from its parent
+	// only, and the others must be in the free list.
+	int32 reached = 0;
+	if (root != b2_nullNode)
+	{
+		if (b2ReadTreeNode(nodes, root).parent != b2_nullNode)
+		{
+			return false;
+		}
+
+		b2GrowableStack<int32, 256> stack;
+		stack.Push(root);
+		while (stack.GetCount() > 0)
+		{
+			int32 nodeId = stack.Pop();
+			b2TreeNode node = b2ReadTreeNode(nodes, nodeId);
+			if (++reached > nodeCount || node.height < 0)
+			{
+				return false;
+			}
+
+			if (node.height > 0)
+			{
+				if (b2ReadTreeNode(nodes, node.child1).parent != nodeId ||
+					b2ReadTreeNode(nodes, node.child2).parent != nodeId)
+				{
+					return false;
+				}
+
+				stack.Push(node.child1);
+				stack.Push(node.child2);
+			}
+		}
+	}
+
+	int32 freeCount = 0;
+	for (int32 nodeId = freeList; nodeId != b2_nullNode; nodeId = b2ReadTreeNode(nodes, nodeId).next)
+	{
+		if (++freeCount > m_nodeCapacity - nodeCount || b2ReadTreeNode(nodes, nodeId).height != -1)
+		{
+			return false;
+		}
+	}
+
+	if (reached != nodeCount || freeCount != m_nodeCapacity - nodeCount)
+	{
+		return false;
+	}
+
+	m_root = root;
+	m_nodeCount = nodeCount;
+	m_freeList = freeList;
+	m_path = (uint32)header[4];
+	m_insertionCount = header[5];
+	memcpy(m_nodes, nodes, m_nodeCapacity * sizeof(b2TreeNode));
+	m_compactValid = false;
+	return true;
+}
@@ -21,6 +21,7 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2GrowableStack.h>
+#include <Box2D/Common/b2Simd.h>
 
 #define b2_nullNode (-1)
 
@@ -50,6 +51,17 @@ struct b2TreeNode
 	int32 height;
 };
 
+/// An internal node of the compacted tree. The bounds of both children are
+/// stored side by side as (child1.x, child2.x, child1.y, child2.y) so they
+/// can be tested against a box at once. A child >= 0 is another compacted
+/// node, a child < 0 is the leaf ~child.
+struct b2CompactNode
+{
+	float32 lower[4];
+	float32 upper[4];
+	int32 children[2];
+};
+
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
 /// A dynamic tree arranges data in a binary tree to accelerate
 /// queries such as volume queries and ray casts. Leafs are proxies
@@ -123,8 +135,39 @@ public:
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Copy the internal nodes into a separate array in depth first order,
+	/// each holding the bounds of both children. Query and RayCast use it,
+	/// with the same results and callback order, until the tree changes.
+	/// Proxy ids are not affected.
+	void Compact();
+
+	/// Is the compacted copy up to date?
+	bool IsCompact() const;
+
+	/// Get the size in bytes of the state written by SaveState.
+	int32 GetStateSize() const;
+
+	/// Copy the nodes into state, so LoadState can put the tree back the way
+	/// it was, down to its shape. The proxy user data pointers are copied as is.
+	void SaveState(void* state) const;
+
+	/// Load a state of size bytes written by SaveState. Returns false, leaving
+	/// the tree untouched, if the state does not fit this tree: its leaves must
+	/// be the proxies of this tree, with the same user data, and the other
+	/// nodes must form a tree and a free list.
+	bool LoadState(const void* state, int32 size);
+
+	/// Is this the id of a proxy of the tree?
+	bool IsProxy(int32 proxyId) const;
+
 private:
 
+	template <typename T>
+	void QueryCompact(T* callback, const b2AABB& aabb) const;
+
+	template <typename T>
+	void RayCastCompact(T* callback, const b2RayCastInput& input) const;
+
 	int32 AllocateNode();
 	void FreeNode(int32 node);
 
@@ -151,8 +194,18 @@ private:
 	uint32 m_path;
 
 	int32 m_insertionCount;
+
+	b2CompactNode* m_compactNodes;
+	int32 m_compactCapacity;
+	int32 m_compactRoot;
+	bool m_compactValid;
 };
 
+inline bool b2DynamicTree::IsProxy(int32 proxyId) const
+{
+	return 0 <= proxyId && proxyId < m_nodeCapacity && m_nodes[proxyId].height == 0;
+}
+
 inline void* b2DynamicTree::GetUserData(int32 proxyId) const
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -165,9 +218,20 @@ inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
 	return m_nodes[proxyId].aabb;
 }
 
+inline bool b2DynamicTree::IsCompact() const
+{
+	return m_compactValid;
+}
+
 template <typename T>
 inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 {
+	if (m_compactValid)
+	{
+		QueryCompact(callback, aabb);
+		return;
+	}
+
 	b2GrowableStack<int32, 256> stack;
 	stack.Push(m_root);
 
@@ -203,6 +267,12 @@ inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 template <typename T>
 inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) const
 {
+	if (m_compactValid)
+	{
+		RayCastCompact(callback, input);
+		return;
+	}
+
 	b2Vec2 p1 = input.p1;
 	b2Vec2 p2 = input.p2;
 	b2Vec2 r = p2 - p1;
@@ -286,4 +356,173 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 	}
 }
 
+// Visits the same leaves in the same order as the pointer-chasing Query.
+// Children are tested while their parent is visited instead of when they
+// are popped.
+template <typename T>
+inline void b2DynamicTree::QueryCompact(T* callback, const b2AABB& aabb) const
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	if (m_compactRoot < 0)
+	{
+		if (b2TestOverlap(m_nodes[m_root].aabb, aabb))
+		{
+			callback->QueryCallback(m_root);
+		}
+		return;
+	}
+
+	// A child overlaps when its lower bound <= the box upper bound and the
+	// box lower bound <= its upper bound, on both axes.
+	b2Float4 lower = b2Set4(aabb.lowerBound.x, aabb.lowerBound.x, aabb.lowerBound.y, aabb.lowerBound.y);
+	b2Float4 upper = b2Set4(aabb.upperBound.x, aabb.upperBound.x, aabb.upperBound.y, aabb.upperBound.y);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_compactRoot);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 child = stack.Pop();
+		if (child < 0)
+		{
+			bool proceed = callback->QueryCallback(~child);
+			if (proceed == false)
+			{
+				return;
+			}
+			continue;
+		}
+
+		const b2CompactNode* node = m_compactNodes + child;
+		int32 mask = b2LessEqualMask4(b2Load4(node->lower), upper) & b2LessEqualMask4(lower, b2Load4(node->upper));
+
+		if ((mask & 5) == 5)
+		{
+			stack.Push(node->children[0]);
+		}
+		if ((mask & 10) == 10)
+		{
+			stack.Push(node->children[1]);
+		}
+	}
+}
+
+// Internal nodes are culled against the segment as it was when their parent
+// was visited, which is never tighter than the current one. Leaves are
+// tested again when popped, so the callbacks match the pointer-chasing
+// RayCast.
+template <typename T>
+inline void b2DynamicTree::RayCastCompact(T* callback, const b2RayCastInput& input) const
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 r = p2 - p1;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float32 maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * (p2 - p1);
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	b2Float4 lower = b2Set4(segmentAABB.lowerBound.x, segmentAABB.lowerBound.x, segmentAABB.lowerBound.y, segmentAABB.lowerBound.y);
+	b2Float4 upper = b2Set4(segmentAABB.upperBound.x, segmentAABB.upperBound.x, segmentAABB.upperBound.y, segmentAABB.upperBound.y);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_compactRoot < 0 ? ~m_root : m_compactRoot);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 child = stack.Pop();
+		if (child < 0)
+		{
+			int32 nodeId = ~child;
+			const b2AABB& aabb = m_nodes[nodeId].aabb;
+			if (b2TestOverlap(aabb, segmentAABB) == false)
+			{
+				continue;
+			}
+
+			// Separating axis for segment (Gino, p80).
+			// |dot(v, p1 - c)| > dot(|v|, h)
+			b2Vec2 c = aabb.GetCenter();
+			b2Vec2 h = aabb.GetExtents();
+			float32 separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+			if (separation > 0.0f)
+			{
+				continue;
+			}
+
+			b2RayCastInput subInput;
+			subInput.p1 = input.p1;
+			subInput.p2 = input.p2;
+			subInput.maxFraction = maxFraction;
+
+			float32 value = callback->RayCastCallback(subInput, nodeId);
+
+			if (value == 0.0f)
+			{
+				// The client has terminated the ray cast.
+				return;
+			}
+
+			if (value > 0.0f)
+			{
+				// Update segment bounding box.
+				maxFraction = value;
+				b2Vec2 t = p1 + maxFraction * (p2 - p1);
+				segmentAABB.lowerBound = b2Min(p1, t);
+				segmentAABB.upperBound = b2Max(p1, t);
+				lower = b2Set4(segmentAABB.lowerBound.x, segmentAABB.lowerBound.x, segmentAABB.lowerBound.y, segmentAABB.lowerBound.y);
+				upper = b2Set4(segmentAABB.upperBound.x, segmentAABB.upperBound.x, segmentAABB.upperBound.y, segmentAABB.upperBound.y);
+			}
+			continue;
+		}
+
+		const b2CompactNode* node = m_compactNodes + child;
+		int32 mask = b2LessEqualMask4(b2Load4(node->lower), upper) & b2LessEqualMask4(lower, b2Load4(node->upper));
+
+		for (int32 i = 0; i < 2; ++i)
+		{
+			if ((mask & (5 << i)) != (5 << i))
+			{
+				continue;
+			}
+
+			// Leaves are tested when popped.
+			int32 next = node->children[i];
+			if (next >= 0)
+			{
+				b2Vec2 c(0.5f * (node->lower[i] + node->upper[i]), 0.5f * (node->lower[2 + i] + node->upper[2 + i]));
+				b2Vec2 h(0.5f * (node->upper[i] - node->lower[i]), 0.5f * (node->upper[2 + i] - node->lower[2 + i]));
+				float32 separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+				if (separation > 0.0f)
+				{
+					continue;
+				}
+			}
+
+			stack.Push(next);
+		}
+	}
+}
+
 #endif
@@ -58,6 +58,8 @@ b2BlockAllocator::b2BlockAllocator()
 
 	m_chunkSpace = b2_chunkArrayIncrement;
 	m_chunkCount = 0;
+	m_blockCount = 0;
+	m_largeAllocationCount = 0;
 	m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
@@ -103,12 +105,14 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
+		++m_largeAllocationCount;
 		return b2Alloc(size);
 	}
 
 	int32 index = s_blockSizeLookup[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
+	++m_blockCount;
 	if (m_freeLists[index])
 	{
 		b2Block* block = m_freeLists[index];
@@ -199,6 +203,7 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	b2Block* block = (b2Block*)p;
 	block->next = m_freeLists[index];
 	m_freeLists[index] = block;
+	--m_blockCount;
 }
 
 void b2BlockAllocator::Clear()
@@ -209,7 +214,23 @@ void b2BlockAllocator::Clear()
 	}
 
 	m_chunkCount = 0;
+	m_blockCount = 0;
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
 	memset(m_freeLists, 0, sizeof(m_freeLists));
 }
+
+int32 b2BlockAllocator::GetChunkCount() const
+{
+	return m_chunkCount;
+}
+
+int32 b2BlockAllocator::GetBlockCount() const
+{
+	return m_blockCount;
+}
+
+int32 b2BlockAllocator::GetLargeAllocationCount() const
+{
+	return m_largeAllocationCount;
+}
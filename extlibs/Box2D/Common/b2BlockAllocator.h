@@ -46,11 +46,23 @@ public:
 
 	void Clear();
 
+	/// Get the number of chunks allocated, each b2_chunkSize bytes.
+	int32 GetChunkCount() const;
+
+	/// Get the number of blocks currently in use.
+	int32 GetBlockCount() const;
+
+	/// Get the number of allocations larger than b2_maxBlockSize, which
+	/// went straight to b2Alloc.
+	int32 GetLargeAllocationCount() const;
+
 private:
 
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
+	int32 m_blockCount;
+	int32 m_largeAllocationCount;
 
 	b2Block* m_freeLists[b2_blockSizes];
 
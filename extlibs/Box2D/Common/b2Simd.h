@@ -0,0 +1,130 @@
+/*
+* Copyright (c) 2014 Jairo Luiz and the RubyAction contributors
+*
+* Not part of the original Box2D distribution; released under the same
+* license as Box2D.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_SIMD_H
+#define B2_SIMD_H
+
+#include <Box2D/Common/b2Settings.h>
+
+// A minimal float vector for solvers that process several constraints or
+// proxies at once. b2_simdWidth lanes are processed per operation: 8 with
+// AVX2, 4 with SSE2 and 4 with the portable fallback. Loads and stores are
+// unaligned, so the data may come from the stack allocator.
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define B2_SIMD_AVX2 1
+const int32 b2_simdWidth = 8;
+
+typedef __m256 b2FloatW;
+
+inline b2FloatW b2LoadW(const float32* p) { return _mm256_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm256_storeu_ps(p, a); }
+inline b2FloatW b2SplatW(float32 a) { return _mm256_set1_ps(a); }
+inline b2FloatW b2ZeroW() { return _mm256_setzero_ps(); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm256_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm256_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm256_mul_ps(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm256_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm256_max_ps(a, b); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline b2FloatW b2LessEqualW(b2FloatW a, b2FloatW b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm256_and_ps(a, b); }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { return _mm256_blendv_ps(b, a, mask); }
+inline int32 b2MaskW(b2FloatW mask) { return _mm256_movemask_ps(mask); }
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define B2_SIMD_SSE2 1
+const int32 b2_simdWidth = 4;
+
+typedef __m128 b2FloatW;
+
+inline b2FloatW b2LoadW(const float32* p) { return _mm_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a); }
+inline b2FloatW b2SplatW(float32 a) { return _mm_set1_ps(a); }
+inline b2FloatW b2ZeroW() { return _mm_setzero_ps(); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm_cmpge_ps(a, b); }
+inline b2FloatW b2LessEqualW(b2FloatW a, b2FloatW b) { return _mm_cmple_ps(a, b); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm_and_ps(a, b); }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline int32 b2MaskW(b2FloatW mask) { return _mm_movemask_ps(mask); }
+
+#else
+
+const int32 b2_simdWidth = 4;
+
+struct b2FloatW
+{
+	float32 v[4];
+};
+
+inline b2FloatW b2LoadW(const float32* p) { b2FloatW r; for (int32 i = 0; i < 4; ++i) r.v[i] = p[i]; return r; }
+inline void b2StoreW(float32* p, b2FloatW a) { for (int32 i = 0; i < 4; ++i) p[i] = a.v[i]; }
+inline b2FloatW b2SplatW(float32 a) { b2FloatW r; for (int32 i = 0; i < 4; ++i) r.v[i] = a; return r; }
+inline b2FloatW b2ZeroW() { return b2SplatW(0.0f); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < 4; ++i) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return a; }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < 4; ++i) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < 4; ++i) a.v[i] = a.v[i] >= b.v[i] ? 1.0f : 0.0f; return a; }
+inline b2FloatW b2LessEqualW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < 4; ++i) a.v[i] = a.v[i] <= b.v[i] ? 1.0f : 0.0f; return a; }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < 4; ++i) a.v[i] = (a.v[i] != 0.0f && b.v[i] != 0.0f) ? 1.0f : 0.0f; return a; }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { for (int32 i = 0; i < 4; ++i) a.v[i] = mask.v[i] != 0.0f ? a.v[i] : b.v[i]; return a; }
+inline int32 b2MaskW(b2FloatW mask) { int32 r = 0; for (int32 i = 0; i < 4; ++i) r |= (mask.v[i] != 0.0f) << i; return r; }
+
+#endif
+
+// A fixed 4-lane vector, for data laid out in pairs such as the bounds of
+// the two children of a tree node.
+#if defined(B2_SIMD_AVX2) || defined(B2_SIMD_SSE2)
+
+typedef __m128 b2Float4;
+
+inline b2Float4 b2Load4(const float32* p) { return _mm_loadu_ps(p); }
+inline b2Float4 b2Set4(float32 a, float32 b, float32 c, float32 d) { return _mm_setr_ps(a, b, c, d); }
+inline int32 b2LessEqualMask4(b2Float4 a, b2Float4 b) { return _mm_movemask_ps(_mm_cmple_ps(a, b)); }
+
+#else
+
+struct b2Float4
+{
+	float32 v[4];
+};
+
+inline b2Float4 b2Load4(const float32* p) { b2Float4 r; for (int32 i = 0; i < 4; ++i) r.v[i] = p[i]; return r; }
+inline b2Float4 b2Set4(float32 a, float32 b, float32 c, float32 d) { b2Float4 r; r.v[0] = a; r.v[1] = b; r.v[2] = c; r.v[3] = d; return r; }
+inline int32 b2LessEqualMask4(b2Float4 a, b2Float4 b) { int32 r = 0; for (int32 i = 0; i < 4; ++i) r |= (a.v[i] <= b.v[i]) << i; return r; }
+
+#endif
+
+#endif
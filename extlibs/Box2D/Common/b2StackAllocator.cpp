@@ -21,7 +21,10 @@
 
 b2StackAllocator::b2StackAllocator()
 {
+	m_data = (char*)b2Alloc(b2_stackSize);
+	m_capacity = b2_stackSize;
 	m_index = 0;
+	m_fallbackCount = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
 	m_entryCount = 0;
@@ -31,6 +34,7 @@ b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
 	b2Assert(m_entryCount == 0);
+	b2Free(m_data);
 }
 
 void* b2StackAllocator::Allocate(int32 size)
@@ -39,10 +43,11 @@ void* b2StackAllocator::Allocate(int32 size)
 
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	if (m_index + size > m_capacity)
 	{
 		entry->data = (char*)b2Alloc(size);
 		entry->usedMalloc = true;
+		++m_fallbackCount;
 	}
 	else
 	{
@@ -74,6 +79,12 @@ void b2StackAllocator::Free(void* p)
 	m_allocation -= entry->size;
 	--m_entryCount;
 
+	// Grow by at least half so a slowly growing peak does not reallocate every step.
+	if (m_entryCount == 0 && m_maxAllocation > m_capacity)
+	{
+		Reserve(b2Max(m_maxAllocation, m_capacity + m_capacity / 2));
+	}
+
 	p = NULL;
 }
 
@@ -81,3 +92,26 @@ int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
 }
+
+int32 b2StackAllocator::GetCapacity() const
+{
+	return m_capacity;
+}
+
+int32 b2StackAllocator::GetFallbackCount() const
+{
+	return m_fallbackCount;
+}
+
+void b2StackAllocator::Reserve(int32 size)
+{
+	b2Assert(m_entryCount == 0);
+	if (m_entryCount > 0 || size <= m_capacity)
+	{
+		return;
+	}
+
+	b2Free(m_data);
+	m_data = (char*)b2Alloc(size);
+	m_capacity = size;
+}
@@ -34,6 +34,8 @@ struct b2StackEntry
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// Allocations that do not fit fall back to b2Alloc. Once the stack is
+// empty again it grows to the high-water mark, so the next step fits.
 class b2StackAllocator
 {
 public:
@@ -43,12 +45,25 @@ public:
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	/// Get the most bytes allocated at once so far, the high-water mark.
 	int32 GetMaxAllocation() const;
 
+	/// Get the size of the stack buffer in bytes.
+	int32 GetCapacity() const;
+
+	/// Get the number of allocations that did not fit the stack and fell back to b2Alloc.
+	int32 GetFallbackCount() const;
+
+	/// Grow the stack buffer to at least the given size in bytes.
+	/// @warning this must be called while nothing is allocated.
+	void Reserve(int32 size);
+
 private:
 
-	char m_data[b2_stackSize];
+	char* m_data;
+	int32 m_capacity;
 	int32 m_index;
+	int32 m_fallbackCount;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
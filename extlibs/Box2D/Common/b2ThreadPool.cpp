@@ -0,0 +1,172 @@
+/*
+* Copyright (c) 2014 Jairo Luiz and the RubyAction contributors
+*
+* Not part of the original Box2D distribution; released under the same
+* license as Box2D.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Common/b2ThreadPool.h>
+
+b2ThreadPool::b2ThreadPool(int32 threadCount)
+{
+	b2Assert(threadCount > 0);
+	m_threadCount = threadCount;
+	m_ranges = new b2WorkRange[threadCount];
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		m_ranges[i].begin = 0;
+		m_ranges[i].end = 0;
+	}
+
+	m_generation = 0;
+	m_busy = 0;
+	m_stop = false;
+	m_task = NULL;
+	m_context = NULL;
+
+	for (int32 i = 1; i < threadCount; ++i)
+	{
+		m_threads.push_back(std::thread(&b2ThreadPool::WorkerMain, this, i));
+	}
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (size_t i = 0; i < m_threads.size(); ++i)
+	{
+		m_threads[i].join();
+	}
+
+	delete [] m_ranges;
+}
+
+void b2ThreadPool::ParallelFor(int32 count, b2ThreadTask* task, void* context)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	if (m_threadCount == 1 || count == 1)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			task(context, i, 0);
+		}
+		return;
+	}
+
+	// Hand every worker an even share up front; stealing balances the rest.
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		std::lock_guard<std::mutex> lock(m_ranges[i].mutex);
+		m_ranges[i].begin = count * i / m_threadCount;
+		m_ranges[i].end = count * (i + 1) / m_threadCount;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = task;
+		m_context = context;
+		m_busy = m_threadCount - 1;
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	Work(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (m_busy > 0)
+	{
+		m_done.wait(lock);
+	}
+	m_task = NULL;
+	m_context = NULL;
+}
+
+void b2ThreadPool::WorkerMain(int32 worker)
+{
+	uint32 generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (m_stop == false && m_generation == generation)
+			{
+				m_wake.wait(lock);
+			}
+
+			if (m_stop)
+			{
+				return;
+			}
+
+			generation = m_generation;
+		}
+
+		Work(worker);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_busy == 0)
+		{
+			m_done.notify_one();
+		}
+	}
+}
+
+void b2ThreadPool::Work(int32 worker)
+{
+	int32 index;
+	while (Pop(worker, &index) || Steal(worker, &index))
+	{
+		m_task(m_context, index, worker);
+	}
+}
+
+bool b2ThreadPool::Pop(int32 worker, int32* index)
+{
+	b2WorkRange* range = m_ranges + worker;
+	std::lock_guard<std::mutex> lock(range->mutex);
+	if (range->begin < range->end)
+	{
+		*index = range->begin++;
+		return true;
+	}
+	return false;
+}
+
+bool b2ThreadPool::Steal(int32 worker, int32* index)
+{
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		b2WorkRange* range = m_ranges + (worker + i) % m_threadCount;
+		std::lock_guard<std::mutex> lock(range->mutex);
+		if (range->begin < range->end)
+		{
+			*index = --range->end;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,91 @@
+/*
+* Copyright (c) 2014 Jairo Luiz and the RubyAction contributors
+*
+* Not part of the original Box2D distribution; released under the same
+* license as Box2D.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_THREAD_POOL_H
+#define B2_THREAD_POOL_H
+
+#include <Box2D/Common/b2Settings.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// A task run by the thread pool. The index identifies the work item and
+/// the worker identifies the thread running it, in [0, thread count).
+typedef void b2ThreadTask(void* context, int32 index, int32 worker);
+
+/// A small work-stealing thread pool. Each worker owns a contiguous
+/// range of work items and steals from the back of other ranges once its
+/// own range is drained. The calling thread takes part as worker 0.
+class b2ThreadPool
+{
+public:
+
+	/// Create a pool with the given number of threads, including the caller.
+	explicit b2ThreadPool(int32 threadCount);
+
+	/// Joins all worker threads.
+	~b2ThreadPool();
+
+	/// Get the number of threads, including the caller.
+	int32 GetThreadCount() const;
+
+	/// Run task(context, i, worker) for every i in [0, count) and
+	/// return once all items have completed.
+	void ParallelFor(int32 count, b2ThreadTask* task, void* context);
+
+private:
+
+	struct b2WorkRange
+	{
+		std::mutex mutex;
+		int32 begin;
+		int32 end;
+	};
+
+	void WorkerMain(int32 worker);
+	void Work(int32 worker);
+	bool Pop(int32 worker, int32* index);
+	bool Steal(int32 worker, int32* index);
+
+	int32 m_threadCount;
+	std::vector<std::thread> m_threads;
+	b2WorkRange* m_ranges;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	uint32 m_generation;
+	int32 m_busy;
+	bool m_stop;
+
+	b2ThreadTask* m_task;
+	void* m_context;
+};
+
+inline int32 b2ThreadPool::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+#endif
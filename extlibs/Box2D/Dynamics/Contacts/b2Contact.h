@@ -180,6 +180,7 @@ protected:
 						b2Shape::Type typeA, b2Shape::Type typeB);
 	static void InitializeRegisters();
 	static b2Contact* Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator);
+	static bool CreatesInOrder(b2Shape::Type typeA, b2Shape::Type typeB);
 	static void Destroy(b2Contact* contact, b2Shape::Type typeA, b2Shape::Type typeB, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
 
@@ -189,6 +190,12 @@ protected:
 
 	void Update(b2ContactListener* listener);
 
+	// Update split in two for the parallel narrow-phase. UpdateManifold only
+	// touches this contact and may run on any thread; UpdateState wakes the
+	// bodies, sets the flags and calls the listener on the main thread.
+	bool UpdateManifold(const b2Manifold* oldManifold);
+	void UpdateState(b2ContactListener* listener, const b2Manifold* oldManifold, bool touching);
+
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
@@ -27,6 +27,7 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2WideVelocityConstraint;
 
 struct b2VelocityConstraintPoint
 {
@@ -64,6 +65,7 @@ struct b2ContactSolverDef
 	b2Position* positions;
 	b2Velocity* velocities;
 	b2StackAllocator* allocator;
+	const b2SolverData* data;	///< resolves body indices, or NULL to use the bodies' own
 };
 
 class b2ContactSolver
@@ -78,6 +80,16 @@ public:
 	void SolveVelocityConstraints();
 	void StoreImpulses();
 
+	/// The scalar solver for a single constraint. This is the reference
+	/// for the SIMD solver.
+	void SolveVelocityConstraint(b2ContactVelocityConstraint* vc);
+
+	/// The SIMD solver packs constraints that share no moving body into
+	/// lanes. See b2ContactSolverWide.cpp.
+	void PrepareWideConstraints();
+	void SolveWideVelocityConstraints();
+	void StoreWideImpulses();
+
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
@@ -89,6 +101,11 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+
+	b2WideVelocityConstraint* m_wideConstraints;
+	int32 m_wideCount;
+	int32* m_overflowConstraints;
+	int32 m_overflowCount;
 };
 
 #endif
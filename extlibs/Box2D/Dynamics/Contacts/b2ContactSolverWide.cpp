@@ -0,0 +1,477 @@
+/*
+* Copyright (c) 2014 Jairo Luiz and the RubyAction contributors
+*
+* Not part of the original Box2D distribution; released under the same
+* license as Box2D.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+
+#include <Box2D/Common/b2Simd.h>
+#include <Box2D/Common/b2StackAllocator.h>
+#include <string.h>
+
+// SIMD velocity solver. Constraints are greedily colored so that no two
+// constraints of a color share a body that can move. Each color is packed
+// into struct-of-arrays batches of b2_simdWidth constraints, split by point
+// count so every lane runs the same code. Solving a batch gives the same
+// result as solving its lanes one after the other with the scalar solver;
+// only the order of constraints differs. Constraints that find no free
+// color are solved by the scalar solver after the batches.
+
+const int32 b2_maxWideColors = 32;
+
+struct b2WideVelocityPoint
+{
+	float32 rAx[b2_simdWidth];
+	float32 rAy[b2_simdWidth];
+	float32 rBx[b2_simdWidth];
+	float32 rBy[b2_simdWidth];
+	float32 normalImpulse[b2_simdWidth];
+	float32 tangentImpulse[b2_simdWidth];
+	float32 normalMass[b2_simdWidth];
+	float32 tangentMass[b2_simdWidth];
+	float32 velocityBias[b2_simdWidth];
+};
+
+struct b2WideVelocityConstraint
+{
+	b2WideVelocityPoint points[b2_maxManifoldPoints];
+	float32 normalX[b2_simdWidth];
+	float32 normalY[b2_simdWidth];
+	float32 normalMassExX[b2_simdWidth];
+	float32 normalMassExY[b2_simdWidth];
+	float32 normalMassEyX[b2_simdWidth];
+	float32 normalMassEyY[b2_simdWidth];
+	float32 KExX[b2_simdWidth];
+	float32 KExY[b2_simdWidth];
+	float32 KEyX[b2_simdWidth];
+	float32 KEyY[b2_simdWidth];
+	float32 friction[b2_simdWidth];
+	float32 tangentSpeed[b2_simdWidth];
+	float32 invMassA[b2_simdWidth];
+	float32 invMassB[b2_simdWidth];
+	float32 invIA[b2_simdWidth];
+	float32 invIB[b2_simdWidth];
+	int32 indexA[b2_simdWidth];
+	int32 indexB[b2_simdWidth];
+	int32 constraints[b2_simdWidth];
+	int32 pointCount;
+	int32 count;
+};
+
+static inline bool b2CanMove(float32 invMass, float32 invI)
+{
+	return invMass > 0.0f || invI > 0.0f;
+}
+
+void b2ContactSolver::PrepareWideConstraints()
+{
+	// Reuse the overflow list to hold the color of each constraint until
+	// the batches are filled.
+	m_overflowConstraints = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+	int32* colors = m_overflowConstraints;
+
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bodyCount = b2Max(bodyCount, b2Max(vc->indexA, vc->indexB) + 1);
+	}
+
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	memset(bodyColors, 0, bodyCount * sizeof(uint32));
+
+	int32 colorCounts[b2_maxWideColors][b2_maxManifoldPoints];
+	memset(colorCounts, 0, sizeof(colorCounts));
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bool moveA = b2CanMove(vc->invMassA, vc->invIA);
+		bool moveB = b2CanMove(vc->invMassB, vc->invIB);
+
+		// Bodies that can't move are only read, so any number of lanes may share them.
+		uint32 used = (moveA ? bodyColors[vc->indexA] : 0) | (moveB ? bodyColors[vc->indexB] : 0);
+
+		int32 color = -1;
+		for (int32 c = 0; c < b2_maxWideColors; ++c)
+		{
+			if ((used & (1u << c)) == 0)
+			{
+				color = c;
+				break;
+			}
+		}
+
+		colors[i] = color;
+		if (color < 0)
+		{
+			continue;
+		}
+
+		if (moveA)
+		{
+			bodyColors[vc->indexA] |= 1u << color;
+		}
+		if (moveB)
+		{
+			bodyColors[vc->indexB] |= 1u << color;
+		}
+		++colorCounts[color][vc->pointCount - 1];
+	}
+
+	m_allocator->Free(bodyColors);
+
+	// Lay the batches out color by color.
+	int32 batchStarts[b2_maxWideColors][b2_maxManifoldPoints];
+	m_wideCount = 0;
+	for (int32 c = 0; c < b2_maxWideColors; ++c)
+	{
+		for (int32 p = 0; p < b2_maxManifoldPoints; ++p)
+		{
+			batchStarts[c][p] = m_wideCount;
+			m_wideCount += (colorCounts[c][p] + b2_simdWidth - 1) / b2_simdWidth;
+		}
+	}
+
+	m_wideConstraints = (b2WideVelocityConstraint*)m_allocator->Allocate(m_wideCount * sizeof(b2WideVelocityConstraint));
+	memset(m_wideConstraints, 0, m_wideCount * sizeof(b2WideVelocityConstraint));
+
+	m_overflowCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		int32 color = colors[i];
+		if (color < 0)
+		{
+			// The color list is read at i >= m_overflowCount, so compacting in place is safe.
+			colors[m_overflowCount++] = i;
+			continue;
+		}
+
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		int32 p = vc->pointCount - 1;
+		b2WideVelocityConstraint* wc = m_wideConstraints + batchStarts[color][p];
+		if (wc->count == b2_simdWidth)
+		{
+			++wc;
+			++batchStarts[color][p];
+		}
+
+		int32 lane = wc->count++;
+		wc->pointCount = vc->pointCount;
+		wc->constraints[lane] = i;
+		wc->indexA[lane] = vc->indexA;
+		wc->indexB[lane] = vc->indexB;
+		wc->invMassA[lane] = vc->invMassA;
+		wc->invMassB[lane] = vc->invMassB;
+		wc->invIA[lane] = vc->invIA;
+		wc->invIB[lane] = vc->invIB;
+		wc->friction[lane] = vc->friction;
+		wc->tangentSpeed[lane] = vc->tangentSpeed;
+		wc->normalX[lane] = vc->normal.x;
+		wc->normalY[lane] = vc->normal.y;
+		wc->normalMassExX[lane] = vc->normalMass.ex.x;
+		wc->normalMassExY[lane] = vc->normalMass.ex.y;
+		wc->normalMassEyX[lane] = vc->normalMass.ey.x;
+		wc->normalMassEyY[lane] = vc->normalMass.ey.y;
+		wc->KExX[lane] = vc->K.ex.x;
+		wc->KExY[lane] = vc->K.ex.y;
+		wc->KEyX[lane] = vc->K.ey.x;
+		wc->KEyY[lane] = vc->K.ey.y;
+
+		for (int32 j = 0; j < vc->pointCount; ++j)
+		{
+			const b2VelocityConstraintPoint* vcp = vc->points + j;
+			b2WideVelocityPoint* wp = wc->points + j;
+			wp->rAx[lane] = vcp->rA.x;
+			wp->rAy[lane] = vcp->rA.y;
+			wp->rBx[lane] = vcp->rB.x;
+			wp->rBy[lane] = vcp->rB.y;
+			wp->normalImpulse[lane] = vcp->normalImpulse;
+			wp->tangentImpulse[lane] = vcp->tangentImpulse;
+			wp->normalMass[lane] = vcp->normalMass;
+			wp->tangentMass[lane] = vcp->tangentMass;
+			wp->velocityBias[lane] = vcp->velocityBias;
+		}
+	}
+}
+
+struct b2WideBody
+{
+	b2FloatW vx, vy, w;
+};
+
+// b2Cross(r, P)
+static inline b2FloatW b2CrossW(b2FloatW rx, b2FloatW ry, b2FloatW Px, b2FloatW Py)
+{
+	return b2SubW(b2MulW(rx, Py), b2MulW(ry, Px));
+}
+
+// Apply the impulse P at r to both bodies.
+static inline void b2ApplyImpulseW(b2WideBody* a, b2WideBody* b,
+	b2FloatW mA, b2FloatW iA, b2FloatW mB, b2FloatW iB,
+	b2FloatW rAx, b2FloatW rAy, b2FloatW rBx, b2FloatW rBy, b2FloatW Px, b2FloatW Py)
+{
+	a->vx = b2SubW(a->vx, b2MulW(mA, Px));
+	a->vy = b2SubW(a->vy, b2MulW(mA, Py));
+	a->w = b2SubW(a->w, b2MulW(iA, b2CrossW(rAx, rAy, Px, Py)));
+
+	b->vx = b2AddW(b->vx, b2MulW(mB, Px));
+	b->vy = b2AddW(b->vy, b2MulW(mB, Py));
+	b->w = b2AddW(b->w, b2MulW(iB, b2CrossW(rBx, rBy, Px, Py)));
+}
+
+// Relative velocity at the contact point, vB + wB x rB - vA - wA x rA.
+static inline void b2RelativeVelocityW(const b2WideBody& a, const b2WideBody& b,
+	b2FloatW rAx, b2FloatW rAy, b2FloatW rBx, b2FloatW rBy, b2FloatW* dvx, b2FloatW* dvy)
+{
+	*dvx = b2AddW(b2SubW(b2SubW(b.vx, b2MulW(b.w, rBy)), a.vx), b2MulW(a.w, rAy));
+	*dvy = b2SubW(b2SubW(b2AddW(b.vy, b2MulW(b.w, rBx)), a.vy), b2MulW(a.w, rAx));
+}
+
+static void b2SolveWideConstraint(b2WideVelocityConstraint* wc, b2Velocity* velocities)
+{
+	int32 count = wc->count;
+
+	float32 buffer[6][b2_simdWidth];
+	memset(buffer, 0, sizeof(buffer));
+	for (int32 l = 0; l < count; ++l)
+	{
+		const b2Velocity& a = velocities[wc->indexA[l]];
+		const b2Velocity& b = velocities[wc->indexB[l]];
+		buffer[0][l] = a.v.x;
+		buffer[1][l] = a.v.y;
+		buffer[2][l] = a.w;
+		buffer[3][l] = b.v.x;
+		buffer[4][l] = b.v.y;
+		buffer[5][l] = b.w;
+	}
+
+	b2WideBody A, B;
+	A.vx = b2LoadW(buffer[0]);
+	A.vy = b2LoadW(buffer[1]);
+	A.w = b2LoadW(buffer[2]);
+	B.vx = b2LoadW(buffer[3]);
+	B.vy = b2LoadW(buffer[4]);
+	B.w = b2LoadW(buffer[5]);
+
+	b2FloatW mA = b2LoadW(wc->invMassA);
+	b2FloatW mB = b2LoadW(wc->invMassB);
+	b2FloatW iA = b2LoadW(wc->invIA);
+	b2FloatW iB = b2LoadW(wc->invIB);
+	b2FloatW zero = b2ZeroW();
+
+	b2FloatW nx = b2LoadW(wc->normalX);
+	b2FloatW ny = b2LoadW(wc->normalY);
+
+	// tangent = b2Cross(normal, 1.0f)
+	b2FloatW tx = ny;
+	b2FloatW ty = b2SubW(zero, nx);
+	b2FloatW friction = b2LoadW(wc->friction);
+	b2FloatW tangentSpeed = b2LoadW(wc->tangentSpeed);
+
+	int32 pointCount = wc->pointCount;
+
+	// Solve tangent constraints first because non-penetration is more important
+	// than friction.
+	for (int32 j = 0; j < pointCount; ++j)
+	{
+		b2WideVelocityPoint* wp = wc->points + j;
+		b2FloatW rAx = b2LoadW(wp->rAx);
+		b2FloatW rAy = b2LoadW(wp->rAy);
+		b2FloatW rBx = b2LoadW(wp->rBx);
+		b2FloatW rBy = b2LoadW(wp->rBy);
+
+		b2FloatW dvx, dvy;
+		b2RelativeVelocityW(A, B, rAx, rAy, rBx, rBy, &dvx, &dvy);
+
+		b2FloatW vt = b2SubW(b2AddW(b2MulW(dvx, tx), b2MulW(dvy, ty)), tangentSpeed);
+		b2FloatW lambda = b2MulW(b2LoadW(wp->tangentMass), b2SubW(zero, vt));
+
+		b2FloatW oldImpulse = b2LoadW(wp->tangentImpulse);
+		b2FloatW maxFriction = b2MulW(friction, b2LoadW(wp->normalImpulse));
+		b2FloatW newImpulse = b2MaxW(b2SubW(zero, maxFriction), b2MinW(b2AddW(oldImpulse, lambda), maxFriction));
+		lambda = b2SubW(newImpulse, oldImpulse);
+		b2StoreW(wp->tangentImpulse, newImpulse);
+
+		b2ApplyImpulseW(&A, &B, mA, iA, mB, iB, rAx, rAy, rBx, rBy, b2MulW(lambda, tx), b2MulW(lambda, ty));
+	}
+
+	if (pointCount == 1)
+	{
+		b2WideVelocityPoint* wp = wc->points;
+		b2FloatW rAx = b2LoadW(wp->rAx);
+		b2FloatW rAy = b2LoadW(wp->rAy);
+		b2FloatW rBx = b2LoadW(wp->rBx);
+		b2FloatW rBy = b2LoadW(wp->rBy);
+
+		b2FloatW dvx, dvy;
+		b2RelativeVelocityW(A, B, rAx, rAy, rBx, rBy, &dvx, &dvy);
+
+		b2FloatW vn = b2AddW(b2MulW(dvx, nx), b2MulW(dvy, ny));
+		b2FloatW lambda = b2SubW(zero, b2MulW(b2LoadW(wp->normalMass), b2SubW(vn, b2LoadW(wp->velocityBias))));
+
+		b2FloatW oldImpulse = b2LoadW(wp->normalImpulse);
+		b2FloatW newImpulse = b2MaxW(b2AddW(oldImpulse, lambda), zero);
+		lambda = b2SubW(newImpulse, oldImpulse);
+		b2StoreW(wp->normalImpulse, newImpulse);
+
+		b2ApplyImpulseW(&A, &B, mA, iA, mB, iB, rAx, rAy, rBx, rBy, b2MulW(lambda, nx), b2MulW(lambda, ny));
+	}
+	else
+	{
+		// The block solver of the scalar path, with the four cases of the
+		// total enumeration evaluated for every lane and the first valid one
+		// selected. Lanes without a valid case keep their impulses.
+		b2WideVelocityPoint* cp1 = wc->points + 0;
+		b2WideVelocityPoint* cp2 = wc->points + 1;
+
+		b2FloatW r1Ax = b2LoadW(cp1->rAx);
+		b2FloatW r1Ay = b2LoadW(cp1->rAy);
+		b2FloatW r1Bx = b2LoadW(cp1->rBx);
+		b2FloatW r1By = b2LoadW(cp1->rBy);
+		b2FloatW r2Ax = b2LoadW(cp2->rAx);
+		b2FloatW r2Ay = b2LoadW(cp2->rAy);
+		b2FloatW r2Bx = b2LoadW(cp2->rBx);
+		b2FloatW r2By = b2LoadW(cp2->rBy);
+
+		b2FloatW ax = b2LoadW(cp1->normalImpulse);
+		b2FloatW ay = b2LoadW(cp2->normalImpulse);
+
+		b2FloatW dv1x, dv1y, dv2x, dv2y;
+		b2RelativeVelocityW(A, B, r1Ax, r1Ay, r1Bx, r1By, &dv1x, &dv1y);
+		b2RelativeVelocityW(A, B, r2Ax, r2Ay, r2Bx, r2By, &dv2x, &dv2y);
+
+		b2FloatW vn1 = b2AddW(b2MulW(dv1x, nx), b2MulW(dv1y, ny));
+		b2FloatW vn2 = b2AddW(b2MulW(dv2x, nx), b2MulW(dv2y, ny));
+
+		// b' = b - K * a
+		b2FloatW KExY = b2LoadW(wc->KExY);
+		b2FloatW KEyX = b2LoadW(wc->KEyX);
+		b2FloatW bx = b2SubW(vn1, b2LoadW(cp1->velocityBias));
+		b2FloatW by = b2SubW(vn2, b2LoadW(cp2->velocityBias));
+		bx = b2SubW(bx, b2AddW(b2MulW(b2LoadW(wc->KExX), ax), b2MulW(KEyX, ay)));
+		by = b2SubW(by, b2AddW(b2MulW(KExY, ax), b2MulW(b2LoadW(wc->KEyY), ay)));
+
+		// Case 4: x1 = 0 and x2 = 0
+		b2FloatW xx = ax;
+		b2FloatW xy = ay;
+		b2FloatW valid = b2AndW(b2GreaterEqualW(bx, zero), b2GreaterEqualW(by, zero));
+		xx = b2SelectW(valid, zero, xx);
+		xy = b2SelectW(valid, zero, xy);
+
+		// Case 3: vn2 = 0 and x1 = 0
+		b2FloatW x3y = b2SubW(zero, b2MulW(b2LoadW(cp2->normalMass), by));
+		b2FloatW vn1Case3 = b2AddW(b2MulW(KEyX, x3y), bx);
+		valid = b2AndW(b2GreaterEqualW(x3y, zero), b2GreaterEqualW(vn1Case3, zero));
+		xx = b2SelectW(valid, zero, xx);
+		xy = b2SelectW(valid, x3y, xy);
+
+		// Case 2: vn1 = 0 and x2 = 0
+		b2FloatW x2x = b2SubW(zero, b2MulW(b2LoadW(cp1->normalMass), bx));
+		b2FloatW vn2Case2 = b2AddW(b2MulW(KExY, x2x), by);
+		valid = b2AndW(b2GreaterEqualW(x2x, zero), b2GreaterEqualW(vn2Case2, zero));
+		xx = b2SelectW(valid, x2x, xx);
+		xy = b2SelectW(valid, zero, xy);
+
+		// Case 1: vn = 0, x = - inv(A) * b'
+		b2FloatW x1x = b2SubW(zero, b2AddW(b2MulW(b2LoadW(wc->normalMassExX), bx), b2MulW(b2LoadW(wc->normalMassEyX), by)));
+		b2FloatW x1y = b2SubW(zero, b2AddW(b2MulW(b2LoadW(wc->normalMassExY), bx), b2MulW(b2LoadW(wc->normalMassEyY), by)));
+		valid = b2AndW(b2GreaterEqualW(x1x, zero), b2GreaterEqualW(x1y, zero));
+		xx = b2SelectW(valid, x1x, xx);
+		xy = b2SelectW(valid, x1y, xy);
+
+		// Apply the incremental impulse.
+		b2FloatW dx = b2SubW(xx, ax);
+		b2FloatW dy = b2SubW(xy, ay);
+		b2FloatW P1x = b2MulW(dx, nx);
+		b2FloatW P1y = b2MulW(dx, ny);
+		b2FloatW P2x = b2MulW(dy, nx);
+		b2FloatW P2y = b2MulW(dy, ny);
+		b2FloatW Px = b2AddW(P1x, P2x);
+		b2FloatW Py = b2AddW(P1y, P2y);
+
+		A.vx = b2SubW(A.vx, b2MulW(mA, Px));
+		A.vy = b2SubW(A.vy, b2MulW(mA, Py));
+		A.w = b2SubW(A.w, b2MulW(iA, b2AddW(b2CrossW(r1Ax, r1Ay, P1x, P1y), b2CrossW(r2Ax, r2Ay, P2x, P2y))));
+
+		B.vx = b2AddW(B.vx, b2MulW(mB, Px));
+		B.vy = b2AddW(B.vy, b2MulW(mB, Py));
+		B.w = b2AddW(B.w, b2MulW(iB, b2AddW(b2CrossW(r1Bx, r1By, P1x, P1y), b2CrossW(r2Bx, r2By, P2x, P2y))));
+
+		b2StoreW(cp1->normalImpulse, xx);
+		b2StoreW(cp2->normalImpulse, xy);
+	}
+
+	b2StoreW(buffer[0], A.vx);
+	b2StoreW(buffer[1], A.vy);
+	b2StoreW(buffer[2], A.w);
+	b2StoreW(buffer[3], B.vx);
+	b2StoreW(buffer[4], B.vy);
+	b2StoreW(buffer[5], B.w);
+	for (int32 l = 0; l < count; ++l)
+	{
+		b2Velocity& a = velocities[wc->indexA[l]];
+		b2Velocity& b = velocities[wc->indexB[l]];
+		a.v.Set(buffer[0][l], buffer[1][l]);
+		a.w = buffer[2][l];
+		b.v.Set(buffer[3][l], buffer[4][l]);
+		b.w = buffer[5][l];
+	}
+}
+
+void b2ContactSolver::SolveWideVelocityConstraints()
+{
+	if (m_count == 0)
+	{
+		return;
+	}
+
+	if (m_wideConstraints == NULL)
+	{
+		PrepareWideConstraints();
+	}
+
+	for (int32 i = 0; i < m_wideCount; ++i)
+	{
+		b2SolveWideConstraint(m_wideConstraints + i, m_velocities);
+	}
+
+	for (int32 i = 0; i < m_overflowCount; ++i)
+	{
+		SolveVelocityConstraint(m_velocityConstraints + m_overflowConstraints[i]);
+	}
+}
+
+void b2ContactSolver::StoreWideImpulses()
+{
+	for (int32 i = 0; i < m_wideCount; ++i)
+	{
+		const b2WideVelocityConstraint* wc = m_wideConstraints + i;
+		for (int32 l = 0; l < wc->count; ++l)
+		{
+			b2ContactVelocityConstraint* vc = m_velocityConstraints + wc->constraints[l];
+			for (int32 j = 0; j < wc->pointCount; ++j)
+			{
+				vc->points[j].normalImpulse = wc->points[j].normalImpulse[l];
+				vc->points[j].tangentImpulse = wc->points[j].tangentImpulse[l];
+			}
+		}
+	}
+}
@@ -101,6 +101,12 @@ public:
 	/// Dump joint to dmLog
 	void Dump();
 
+	/// @see b2Joint::GetState
+	void GetState(b2JointState* state) const;
+
+	/// @see b2Joint::SetState
+	void SetState(const b2JointState& state);
+
 protected:
 
 	friend class b2Joint;
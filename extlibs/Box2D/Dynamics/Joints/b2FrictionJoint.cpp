@@ -55,8 +55,8 @@ b2FrictionJoint::b2FrictionJoint(const b2FrictionJointDef* def)
 
 void b2FrictionJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
+	m_indexA = data.GetIndex(m_bodyA);
+	m_indexB = data.GetIndex(m_bodyB);
 	m_localCenterA = m_bodyA->m_sweep.localCenter;
 	m_localCenterB = m_bodyB->m_sweep.localCenter;
 	m_invMassA = m_bodyA->m_invMass;
@@ -249,3 +249,18 @@ void b2FrictionJoint::Dump()
 	b2Log("  jd.maxTorque = %.15lef;\n", m_maxTorque);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2FrictionJoint::GetState(b2JointState* state) const
+{
+	b2Joint::GetState(state);
+	state->impulses[0] = m_linearImpulse.x;
+	state->impulses[1] = m_linearImpulse.y;
+	state->impulses[2] = m_angularImpulse;
+}
+
+void b2FrictionJoint::SetState(const b2JointState& state)
+{
+	m_linearImpulse.x = state.impulses[0];
+	m_linearImpulse.y = state.impulses[1];
+	m_angularImpulse = state.impulses[2];
+}
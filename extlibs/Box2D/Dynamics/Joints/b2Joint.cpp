@@ -209,3 +209,12 @@ bool b2Joint::IsActive() const
 {
 	return m_bodyA->IsActive() && m_bodyB->IsActive();
 }
+
+void b2Joint::GetState(b2JointState* state) const
+{
+	for (int32 i = 0; i < 4; ++i)
+	{
+		state->impulses[i] = 0.0f;
+	}
+	state->limitState = e_inactiveLimit;
+}
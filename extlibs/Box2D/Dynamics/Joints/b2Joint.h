@@ -98,6 +98,14 @@ struct b2JointDef
 	bool collideConnected;
 };
 
+/// The solver state a joint carries from one step to the next. The meaning
+/// of each impulse depends on the joint type.
+struct b2JointState
+{
+	float32 impulses[4];
+	int32 limitState;
+};
+
 /// The base joint class. Joints are used to constraint two bodies together in
 /// various fashions. Some joints also feature limits and motors.
 class b2Joint
@@ -149,6 +157,13 @@ public:
 	/// Shift the origin for any points stored in world coordinates.
 	virtual void ShiftOrigin(const b2Vec2& newOrigin) { B2_NOT_USED(newOrigin);  }
 
+	/// Get the accumulated impulses that warm start the next step. This is
+	/// what a world snapshot saves for each joint.
+	virtual void GetState(b2JointState* state) const;
+
+	/// Set the state returned by GetState.
+	virtual void SetState(const b2JointState& state) { B2_NOT_USED(state); }
+
 protected:
 	friend class b2World;
 	friend class b2Body;
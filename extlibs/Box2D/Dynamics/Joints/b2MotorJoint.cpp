@@ -60,8 +60,8 @@ b2MotorJoint::b2MotorJoint(const b2MotorJointDef* def)
 
 void b2MotorJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
+	m_indexA = data.GetIndex(m_bodyA);
+	m_indexB = data.GetIndex(m_bodyB);
 	m_localCenterA = m_bodyA->m_sweep.localCenter;
 	m_localCenterB = m_bodyB->m_sweep.localCenter;
 	m_invMassA = m_bodyA->m_invMass;
@@ -302,3 +302,18 @@ void b2MotorJoint::Dump()
 	b2Log("  jd.correctionFactor = %.15lef;\n", m_correctionFactor);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2MotorJoint::GetState(b2JointState* state) const
+{
+	b2Joint::GetState(state);
+	state->impulses[0] = m_linearImpulse.x;
+	state->impulses[1] = m_linearImpulse.y;
+	state->impulses[2] = m_angularImpulse;
+}
+
+void b2MotorJoint::SetState(const b2JointState& state)
+{
+	m_linearImpulse.x = state.impulses[0];
+	m_linearImpulse.y = state.impulses[1];
+	m_angularImpulse = state.impulses[2];
+}
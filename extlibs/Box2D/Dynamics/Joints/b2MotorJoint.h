@@ -94,6 +94,12 @@ public:
 	/// Dump to b2Log
 	void Dump();
 
+	/// @see b2Joint::GetState
+	void GetState(b2JointState* state) const;
+
+	/// @see b2Joint::SetState
+	void SetState(const b2JointState& state);
+
 protected:
 
 	friend class b2Joint;
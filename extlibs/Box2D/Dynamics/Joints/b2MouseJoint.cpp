@@ -95,7 +95,7 @@ float32 b2MouseJoint::GetDampingRatio() const
 
 void b2MouseJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexB = m_bodyB->m_islandIndex;
+	m_indexB = data.GetIndex(m_bodyB);
 	m_localCenterB = m_bodyB->m_sweep.localCenter;
 	m_invMassB = m_bodyB->m_invMass;
 	m_invIB = m_bodyB->m_invI;
@@ -220,3 +220,16 @@ void b2MouseJoint::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	m_targetA -= newOrigin;
 }
+
+void b2MouseJoint::GetState(b2JointState* state) const
+{
+	b2Joint::GetState(state);
+	state->impulses[0] = m_impulse.x;
+	state->impulses[1] = m_impulse.y;
+}
+
+void b2MouseJoint::SetState(const b2JointState& state)
+{
+	m_impulse.x = state.impulses[0];
+	m_impulse.y = state.impulses[1];
+}
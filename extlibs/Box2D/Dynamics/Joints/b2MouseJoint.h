@@ -92,6 +92,12 @@ public:
 	/// The mouse joint does not support dumping.
 	void Dump() { b2Log("Mouse joint dumping is not supported.\n"); }
 
+	/// @see b2Joint::GetState
+	void GetState(b2JointState* state) const;
+
+	/// @see b2Joint::SetState
+	void SetState(const b2JointState& state);
+
 	/// Implement b2Joint::ShiftOrigin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
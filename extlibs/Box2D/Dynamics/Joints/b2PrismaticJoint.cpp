@@ -125,8 +125,8 @@ b2PrismaticJoint::b2PrismaticJoint(const b2PrismaticJointDef* def)
 
 void b2PrismaticJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
+	m_indexA = data.GetIndex(m_bodyA);
+	m_indexB = data.GetIndex(m_bodyB);
 	m_localCenterA = m_bodyA->m_sweep.localCenter;
 	m_localCenterB = m_bodyB->m_sweep.localCenter;
 	m_invMassA = m_bodyA->m_invMass;
@@ -624,3 +624,22 @@ void b2PrismaticJoint::Dump()
 	b2Log("  jd.maxMotorForce = %.15lef;\n", m_maxMotorForce);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2PrismaticJoint::GetState(b2JointState* state) const
+{
+	b2Joint::GetState(state);
+	state->impulses[0] = m_impulse.x;
+	state->impulses[1] = m_impulse.y;
+	state->impulses[2] = m_impulse.z;
+	state->impulses[3] = m_motorImpulse;
+	state->limitState = m_limitState;
+}
+
+void b2PrismaticJoint::SetState(const b2JointState& state)
+{
+	m_impulse.x = state.impulses[0];
+	m_impulse.y = state.impulses[1];
+	m_impulse.z = state.impulses[2];
+	m_motorImpulse = state.impulses[3];
+	m_limitState = (b2LimitState)state.limitState;
+}
@@ -390,6 +390,7 @@ private:
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2Contact;
+	friend struct b2SolverData;
 	
 	friend class b2DistanceJoint;
 	friend class b2FrictionJoint;
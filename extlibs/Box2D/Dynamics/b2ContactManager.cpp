@@ -21,6 +21,7 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Common/b2ThreadPool.h>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
@@ -32,6 +33,15 @@ b2ContactManager::b2ContactManager()
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+	m_threadPool = NULL;
+	m_updates = NULL;
+	m_updateCapacity = 0;
+	m_updateCount = 0;
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	b2Free(m_updates);
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -99,11 +109,44 @@ void b2ContactManager::Destroy(b2Contact* c)
 	--m_contactCount;
 }
 
+// What Collide does with a contact, in contact list order.
+enum b2ContactAction
+{
+	b2_updateContact,
+	b2_destroyContact,
+	b2_sleepingContact
+};
+
+// A contact gathered by Collide, with the state needed to finish it on the
+// main thread. Contacts whose bodies are both asleep are recorded too, in
+// case an earlier contact wakes one of them.
+struct b2ContactUpdate
+{
+	b2Contact* contact;
+	b2Manifold oldManifold;
+	bool touching;
+	b2ContactAction action;
+};
+
+// Contacts per narrow-phase task.
+const int32 b2_collideBlockSize = 32;
+
 // This is the top level collision call for the time step. Here
 // all the narrow phase collision is processed for the world
 // contact list.
 void b2ContactManager::Collide()
 {
+	// With a thread pool, contacts are gathered first and finished below,
+	// their manifolds updated in parallel.
+	bool parallel = m_threadPool != NULL;
+	int32 updateCount = 0;
+	if (parallel && m_updateCapacity < m_contactCount)
+	{
+		b2Free(m_updates);
+		m_updateCapacity = b2Max(m_contactCount, 2 * m_updateCapacity);
+		m_updates = (b2ContactUpdate*)b2Alloc(m_updateCapacity * sizeof(b2ContactUpdate));
+	}
+
 	// Update awake contacts.
 	b2Contact* c = m_contactList;
 	while (c)
@@ -114,58 +157,138 @@ void b2ContactManager::Collide()
 		int32 indexB = c->GetChildIndexB();
 		b2Body* bodyA = fixtureA->GetBody();
 		b2Body* bodyB = fixtureB->GetBody();
+		b2ContactAction action = b2_updateContact;
 		 
 		// Is this contact flagged for filtering?
 		if (c->m_flags & b2Contact::e_filterFlag)
 		{
-			// Should these bodies collide?
-			if (bodyB->ShouldCollide(bodyA) == false)
+			// Should these bodies collide? Check user filtering.
+			if (bodyB->ShouldCollide(bodyA) == false ||
+				(m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false))
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
-				continue;
+				action = b2_destroyContact;
 			}
+			else
+			{
+				// Clear the filtering flag.
+				c->m_flags &= ~b2Contact::e_filterFlag;
+			}
+		}
+
+		if (action == b2_updateContact)
+		{
+			bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+			bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
 
-			// Check user filtering.
-			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
+			// At least one body must be awake and it must be dynamic or kinematic.
+			if (activeA == false && activeB == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
-				continue;
+				action = b2_sleepingContact;
 			}
+			else
+			{
+				// Here we destroy contacts that cease to overlap in the broad-phase.
+				int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+				int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
+				if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
+				{
+					action = b2_destroyContact;
+				}
+			}
+		}
+
+		b2Contact* next = c->GetNext();
+		if (parallel)
+		{
+			b2ContactUpdate* update = m_updates + updateCount++;
+			update->contact = c;
+			update->action = action;
+		}
+		else if (action == b2_destroyContact)
+		{
+			Destroy(c);
+		}
+		else if (action == b2_updateContact)
+		{
+			// The contact persists.
+			c->Update(m_contactListener);
+		}
+		c = next;
+	}
+
+	if (parallel)
+	{
+		CollideParallel(updateCount);
+	}
+}
+
+void b2ContactManager::CollideTask(void* context, int32 index, int32 worker)
+{
+	B2_NOT_USED(worker);
+
+	b2ContactManager* manager = (b2ContactManager*)context;
+	int32 begin = index * b2_collideBlockSize;
+	int32 end = b2Min(begin + b2_collideBlockSize, manager->m_updateCount);
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2ContactUpdate* update = manager->m_updates + i;
+		if (update->action != b2_updateContact)
+		{
+			continue;
+		}
+
+		update->oldManifold = update->contact->m_manifold;
+		update->touching = update->contact->UpdateManifold(&update->oldManifold);
+	}
+}
 
-			// Clear the filtering flag.
-			c->m_flags &= ~b2Contact::e_filterFlag;
+void b2ContactManager::CollideParallel(int32 count)
+{
+	// Manifolds are computed on the pool. Waking bodies, destroying contacts
+	// and the listener callbacks then run here in contact list order, as in
+	// the serial path.
+	m_updateCount = count;
+	int32 blockCount = (count + b2_collideBlockSize - 1) / b2_collideBlockSize;
+	m_threadPool->ParallelFor(blockCount, CollideTask, this);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2ContactUpdate* update = m_updates + i;
+		b2Contact* c = update->contact;
+		if (update->action == b2_updateContact)
+		{
+			c->UpdateState(m_contactListener, &update->oldManifold, update->touching);
+			continue;
+		}
+
+		if (update->action == b2_destroyContact)
+		{
+			Destroy(c);
+			continue;
 		}
 
+		// The serial path would see a body woken by an earlier contact, so
+		// finish this one as it does.
+		b2Fixture* fixtureA = c->GetFixtureA();
+		b2Fixture* fixtureB = c->GetFixtureB();
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
 		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
 		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
-
-		// At least one body must be awake and it must be dynamic or kinematic.
 		if (activeA == false && activeB == false)
 		{
-			c = c->GetNext();
 			continue;
 		}
 
-		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
-		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
-		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
-
-		// Here we destroy contacts that cease to overlap in the broad-phase.
-		if (overlap == false)
+		int32 proxyIdA = fixtureA->m_proxies[c->GetChildIndexA()].proxyId;
+		int32 proxyIdB = fixtureB->m_proxies[c->GetChildIndexB()].proxyId;
+		if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
 		{
-			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
-			Destroy(cNuke);
+			Destroy(c);
 			continue;
 		}
 
-		// The contact persists.
 		c->Update(m_contactListener);
-		c = c->GetNext();
 	}
 }
 
@@ -235,8 +358,7 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
-	// Call the factory.
-	b2Contact* c = b2Contact::Create(fixtureA, indexA, fixtureB, indexB, m_allocator);
+	b2Contact* c = Create(fixtureA, indexA, fixtureB, indexB);
 	if (c == NULL)
 	{
 		return;
@@ -245,11 +367,30 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	// Contact creation may swap fixtures.
 	fixtureA = c->GetFixtureA();
 	fixtureB = c->GetFixtureB();
-	indexA = c->GetChildIndexA();
-	indexB = c->GetChildIndexB();
 	bodyA = fixtureA->GetBody();
 	bodyB = fixtureB->GetBody();
 
+	// Wake up the bodies
+	if (fixtureA->IsSensor() == false && fixtureB->IsSensor() == false)
+	{
+		bodyA->SetAwake(true);
+		bodyB->SetAwake(true);
+	}
+}
+
+b2Contact* b2ContactManager::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB)
+{
+	// Call the factory.
+	b2Contact* c = b2Contact::Create(fixtureA, indexA, fixtureB, indexB, m_allocator);
+	if (c == NULL)
+	{
+		return NULL;
+	}
+
+	// Contact creation may swap fixtures.
+	b2Body* bodyA = c->GetFixtureA()->GetBody();
+	b2Body* bodyB = c->GetFixtureB()->GetBody();
+
 	// Insert into the world.
 	c->m_prev = NULL;
 	c->m_next = m_contactList;
@@ -285,12 +426,6 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 	bodyB->m_contactList = &c->m_nodeB;
 
-	// Wake up the bodies
-	if (fixtureA->IsSensor() == false && fixtureB->IsSensor() == false)
-	{
-		bodyA->SetAwake(true);
-		bodyB->SetAwake(true);
-	}
-
 	++m_contactCount;
+	return c;
 }
@@ -23,30 +23,48 @@
 
 class b2Contact;
 class b2ContactFilter;
+class b2Fixture;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2ThreadPool;
+struct b2ContactUpdate;
 
 // Delegate of b2World.
 class b2ContactManager
 {
 public:
 	b2ContactManager();
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
 
+	// Create a contact and link it into the world and body contact lists,
+	// without filtering or waking the bodies.
+	b2Contact* Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
+
 	void FindNewContacts();
 
 	void Destroy(b2Contact* c);
 
 	void Collide();
-            
+
+	// Narrow-phase for the contacts gathered by Collide, on the thread pool.
+	void CollideParallel(int32 count);
+	static void CollideTask(void* context, int32 index, int32 worker);
+
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
 	int32 m_contactCount;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+
+	// Set by b2World when it solves on more than one thread.
+	b2ThreadPool* m_threadPool;
+	b2ContactUpdate* m_updates;
+	int32 m_updateCapacity;
+	int32 m_updateCount;
 };
 
 #endif
@@ -28,6 +28,7 @@ class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
 struct b2ContactVelocityConstraint;
+struct b2ContactImpulse;
 struct b2Profile;
 
 /// This is an internal class.
@@ -78,6 +79,14 @@ public:
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
 
+	// Set when islands are solved concurrently. Static bodies are shared
+	// between islands, so they are left untouched and their indices in this
+	// island are looked up in m_statics, and post-solve impulses are buffered
+	// for the world to report.
+	b2IslandIndex* m_statics;
+	int32 m_staticCount;
+	b2ContactImpulse* m_impulses;
+
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
 
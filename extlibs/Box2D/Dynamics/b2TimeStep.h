@@ -43,6 +43,7 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool simdSolving;
 };
 
 /// This is an internal structure.
@@ -59,12 +60,28 @@ struct b2Velocity
 	float32 w;
 };
 
+class b2Body;
+
+/// The index of a static body in the state buffers of an island. Islands
+/// solved concurrently share their static bodies, so each of them keeps
+/// its own indices for those, sorted by body.
+struct b2IslandIndex
+{
+	const b2Body* body;
+	int32 index;
+};
+
 /// Solver Data
 struct b2SolverData
 {
 	b2TimeStep step;
 	b2Position* positions;
 	b2Velocity* velocities;
+	const b2IslandIndex* statics;
+	int32 staticCount;
+
+	/// Get the index of a body of the island in the state buffers.
+	int32 GetIndex(const b2Body* body) const;
 };
 
 #endif
@@ -31,7 +31,9 @@
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2ThreadPool.h>
 #include <Box2D/Common/b2Timer.h>
+#include <algorithm>
 #include <new>
 
 b2World::b2World(const b2Vec2& gravity)
@@ -44,8 +46,11 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_bodyCount = 0;
 	m_jointCount = 0;
+	m_islandCount = 0;
 
 	m_warmStarting = true;
+	m_simdSolving = false;
+	m_treeCompaction = false;
 	m_continuousPhysics = true;
 	m_subStepping = false;
 
@@ -60,6 +65,9 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_contactManager.m_allocator = &m_blockAllocator;
 
+	m_threadPool = NULL;
+	m_threadAllocators = NULL;
+
 	memset(&m_profile, 0, sizeof(b2Profile));
 }
 
@@ -82,6 +90,52 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	SetThreadCount(1);
+}
+
+void b2World::SetThreadCount(int32 count)
+{
+	b2Assert(IsLocked() == false);
+	b2Assert(count > 0);
+	if (IsLocked() || count == GetThreadCount())
+	{
+		return;
+	}
+
+	if (m_threadPool)
+	{
+		int32 allocatorCount = m_threadPool->GetThreadCount() - 1;
+		for (int32 i = 0; i < allocatorCount; ++i)
+		{
+			m_threadAllocators[i].~b2StackAllocator();
+		}
+		b2Free(m_threadAllocators);
+		m_threadAllocators = NULL;
+
+		m_threadPool->~b2ThreadPool();
+		b2Free(m_threadPool);
+		m_threadPool = NULL;
+		m_contactManager.m_threadPool = NULL;
+	}
+
+	if (count > 1)
+	{
+		void* mem = b2Alloc(sizeof(b2ThreadPool));
+		m_threadPool = new (mem) b2ThreadPool(count);
+		m_contactManager.m_threadPool = m_threadPool;
+
+		m_threadAllocators = (b2StackAllocator*)b2Alloc((count - 1) * sizeof(b2StackAllocator));
+		for (int32 i = 0; i < count - 1; ++i)
+		{
+			new (m_threadAllocators + i) b2StackAllocator;
+		}
+	}
+}
+
+int32 b2World::GetThreadCount() const
+{
+	return m_threadPool ? m_threadPool->GetThreadCount() : 1;
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -382,13 +436,108 @@ void b2World::SetAllowSleeping(bool flag)
 	}
 }
 
-// Find islands, integrate and solve constraints, solve position constraints
-void b2World::Solve(const b2TimeStep& step)
+// Collect the island reachable from seed with a depth first search (DFS)
+// on the constraint graph, appending to the given island.
+void b2World::BuildIsland(b2Body* seed, b2Island* island, b2Body** stack, int32 stackSize)
 {
-	m_profile.solveInit = 0.0f;
-	m_profile.solveVelocity = 0.0f;
-	m_profile.solvePosition = 0.0f;
+	B2_NOT_USED(stackSize);
+
+	int32 stackCount = 0;
+	stack[stackCount++] = seed;
+	seed->m_flags |= b2Body::e_islandFlag;
+
+	while (stackCount > 0)
+	{
+		// Grab the next body off the stack and add it to the island.
+		b2Body* b = stack[--stackCount];
+		b2Assert(b->IsActive() == true);
+		island->Add(b);
+
+		// Make sure the body is awake.
+		b->SetAwake(true);
+
+		// To keep islands as small as possible, we don't
+		// propagate islands across static bodies.
+		if (b->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		// Search all contacts connected to this body.
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			b2Contact* contact = ce->contact;
+
+			// Has this contact already been added to an island?
+			if (contact->m_flags & b2Contact::e_islandFlag)
+			{
+				continue;
+			}
+
+			// Is this contact solid and touching?
+			if (contact->IsEnabled() == false ||
+				contact->IsTouching() == false)
+			{
+				continue;
+			}
+
+			// Skip sensors.
+			bool sensorA = contact->m_fixtureA->m_isSensor;
+			bool sensorB = contact->m_fixtureB->m_isSensor;
+			if (sensorA || sensorB)
+			{
+				continue;
+			}
+
+			island->Add(contact);
+			contact->m_flags |= b2Contact::e_islandFlag;
+
+			b2Body* other = ce->other;
+
+			// Was the other body already added to this island?
+			if (other->m_flags & b2Body::e_islandFlag)
+			{
+				continue;
+			}
+
+			b2Assert(stackCount < stackSize);
+			stack[stackCount++] = other;
+			other->m_flags |= b2Body::e_islandFlag;
+		}
+
+		// Search all joints connect to this body.
+		for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+		{
+			if (je->joint->m_islandFlag == true)
+			{
+				continue;
+			}
+
+			b2Body* other = je->other;
+
+			// Don't simulate joints connected to inactive bodies.
+			if (other->IsActive() == false)
+			{
+				continue;
+			}
+
+			island->Add(je->joint);
+			je->joint->m_islandFlag = true;
+
+			if (other->m_flags & b2Body::e_islandFlag)
+			{
+				continue;
+			}
+
+			b2Assert(stackCount < stackSize);
+			stack[stackCount++] = other;
+			other->m_flags |= b2Body::e_islandFlag;
+		}
+	}
+}
 
+void b2World::SolveIslands(const b2TimeStep& step)
+{
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
@@ -396,20 +545,6 @@ void b2World::Solve(const b2TimeStep& step)
 					&m_stackAllocator,
 					m_contactManager.m_contactListener);
 
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
-	{
-		b->m_flags &= ~b2Body::e_islandFlag;
-	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
-	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
-	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
-	{
-		j->m_islandFlag = false;
-	}
-
 	// Build and simulate all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
@@ -433,111 +568,152 @@ void b2World::Solve(const b2TimeStep& step)
 
 		// Reset island and stack.
 		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
+		BuildIsland(seed, &island, stack, stackSize);
+		++m_islandCount;
 
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
-		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
-			b2Assert(b->IsActive() == true);
-			island.Add(b);
-
-			// Make sure the body is awake.
-			b->SetAwake(true);
+		b2Profile profile;
+		island.Solve(&profile, step, m_gravity, m_allowSleep);
+		m_profile.solveInit += profile.solveInit;
+		m_profile.solveVelocity += profile.solveVelocity;
+		m_profile.solvePosition += profile.solvePosition;
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
+		// Post solve cleanup.
+		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		{
+			// Allow static bodies to participate in other islands.
+			b2Body* b = island.m_bodies[i];
 			if (b->GetType() == b2_staticBody)
 			{
-				continue;
+				b->m_flags &= ~b2Body::e_islandFlag;
 			}
+		}
+	}
 
-			// Search all contacts connected to this body.
-			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
-			{
-				b2Contact* contact = ce->contact;
+	m_stackAllocator.Free(stack);
+}
 
-				// Has this contact already been added to an island?
-				if (contact->m_flags & b2Contact::e_islandFlag)
-				{
-					continue;
-				}
+// A slice of the collected islands, solved by one pool task.
+struct b2IslandRange
+{
+	int32 bodyStart, bodyCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+	b2Profile profile;
+};
 
-				// Is this contact solid and touching?
-				if (contact->IsEnabled() == false ||
-					contact->IsTouching() == false)
-				{
-					continue;
-				}
+struct b2IslandTaskContext
+{
+	b2World* world;
+	const b2TimeStep* step;
+	const b2Island* islands;
+	b2IslandRange* ranges;
+	b2ContactImpulse* impulses;
+};
 
-				// Skip sensors.
-				bool sensorA = contact->m_fixtureA->m_isSensor;
-				bool sensorB = contact->m_fixtureB->m_isSensor;
-				if (sensorA || sensorB)
-				{
-					continue;
-				}
+static bool b2IslandIndexLessThan(const b2IslandIndex& index1, const b2IslandIndex& index2)
+{
+	return index1.body < index2.body;
+}
 
-				island.Add(contact);
-				contact->m_flags |= b2Contact::e_islandFlag;
+void b2World::SolveIslandTask(void* context, int32 index, int32 worker)
+{
+	b2IslandTaskContext* task = (b2IslandTaskContext*)context;
+	b2World* world = task->world;
+	b2IslandRange* range = task->ranges + index;
+	const b2Island* islands = task->islands;
 
-				b2Body* other = ce->other;
+	b2StackAllocator* allocator = &world->m_stackAllocator;
+	if (worker > 0)
+	{
+		allocator = world->m_threadAllocators + worker - 1;
+	}
 
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+	b2Island island(range->bodyCount, range->contactCount, range->jointCount, allocator, NULL);
+	memcpy(island.m_bodies, islands->m_bodies + range->bodyStart, range->bodyCount * sizeof(b2Body*));
+	memcpy(island.m_contacts, islands->m_contacts + range->contactStart, range->contactCount * sizeof(b2Contact*));
+	memcpy(island.m_joints, islands->m_joints + range->jointStart, range->jointCount * sizeof(b2Joint*));
+	island.m_bodyCount = range->bodyCount;
+	island.m_contactCount = range->contactCount;
+	island.m_jointCount = range->jointCount;
+
+	// Every island keeps its own indices for the static bodies it shares.
+	island.m_statics = (b2IslandIndex*)allocator->Allocate(range->bodyCount * sizeof(b2IslandIndex));
+	for (int32 i = 0; i < island.m_bodyCount; ++i)
+	{
+		const b2Body* b = island.m_bodies[i];
+		if (b->GetType() == b2_staticBody)
+		{
+			b2IslandIndex* index = island.m_statics + island.m_staticCount++;
+			index->body = b;
+			index->index = i;
+		}
+	}
+	std::sort(island.m_statics, island.m_statics + island.m_staticCount, b2IslandIndexLessThan);
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+	if (task->impulses)
+	{
+		island.m_impulses = task->impulses + range->contactStart;
+	}
 
-			// Search all joints connect to this body.
-			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
-			{
-				if (je->joint->m_islandFlag == true)
-				{
-					continue;
-				}
+	island.Solve(&range->profile, *task->step, world->m_gravity, world->m_allowSleep);
 
-				b2Body* other = je->other;
+	allocator->Free(island.m_statics);
+}
 
-				// Don't simulate joints connected to inactive bodies.
-				if (other->IsActive() == false)
-				{
-					continue;
-				}
+// Collect every awake island up front, then solve them on the thread pool.
+// Islands are collected in the same order as the serial solver and post-solve
+// callbacks are delivered in that order afterwards, so the result does not
+// depend on the thread count or on scheduling.
+void b2World::SolveIslandsParallel(const b2TimeStep& step)
+{
+	int32 contactCount = m_contactManager.m_contactCount;
 
-				island.Add(je->joint);
-				je->joint->m_islandFlag = true;
+	// Static bodies may appear once per island, and each extra appearance
+	// is reached through a contact or a joint.
+	b2Island islands(m_bodyCount + contactCount + m_jointCount,
+					contactCount,
+					m_jointCount,
+					&m_stackAllocator,
+					NULL);
 
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+	int32 stackSize = m_bodyCount;
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+	b2IslandRange* ranges = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+	int32 rangeCount = 0;
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	{
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
 		}
 
-		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
+		if (seed->IsAwake() == false || seed->IsActive() == false)
+		{
+			continue;
+		}
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		// The seed can be dynamic or kinematic.
+		if (seed->GetType() == b2_staticBody)
 		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
+			continue;
+		}
+
+		b2IslandRange* range = ranges + rangeCount++;
+		range->bodyStart = islands.m_bodyCount;
+		range->contactStart = islands.m_contactCount;
+		range->jointStart = islands.m_jointCount;
+
+		BuildIsland(seed, &islands, stack, stackSize);
+
+		range->bodyCount = islands.m_bodyCount - range->bodyStart;
+		range->contactCount = islands.m_contactCount - range->contactStart;
+		range->jointCount = islands.m_jointCount - range->jointStart;
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = range->bodyStart; i < islands.m_bodyCount; ++i)
+		{
+			b2Body* b = islands.m_bodies[i];
 			if (b->GetType() == b2_staticBody)
 			{
 				b->m_flags &= ~b2Body::e_islandFlag;
@@ -545,7 +721,74 @@ void b2World::Solve(const b2TimeStep& step)
 		}
 	}
 
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	b2ContactImpulse* impulses = NULL;
+	if (listener)
+	{
+		impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(islands.m_contactCount * sizeof(b2ContactImpulse));
+	}
+
+	b2IslandTaskContext context;
+	context.world = this;
+	context.step = &step;
+	context.islands = &islands;
+	context.ranges = ranges;
+	context.impulses = impulses;
+
+	m_threadPool->ParallelFor(rangeCount, SolveIslandTask, &context);
+	m_islandCount = rangeCount;
+
+	for (int32 i = 0; i < rangeCount; ++i)
+	{
+		m_profile.solveInit += ranges[i].profile.solveInit;
+		m_profile.solveVelocity += ranges[i].profile.solveVelocity;
+		m_profile.solvePosition += ranges[i].profile.solvePosition;
+	}
+
+	if (impulses)
+	{
+		for (int32 i = 0; i < islands.m_contactCount; ++i)
+		{
+			listener->PostSolve(islands.m_contacts[i], impulses + i);
+		}
+
+		m_stackAllocator.Free(impulses);
+	}
+
+	m_stackAllocator.Free(ranges);
 	m_stackAllocator.Free(stack);
+}
+
+// Find islands, integrate and solve constraints, solve position constraints
+void b2World::Solve(const b2TimeStep& step)
+{
+	m_profile.solveInit = 0.0f;
+	m_profile.solveVelocity = 0.0f;
+	m_profile.solvePosition = 0.0f;
+	m_islandCount = 0;
+
+	// Clear all the island flags.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_flags &= ~b2Body::e_islandFlag;
+	}
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		c->m_flags &= ~b2Contact::e_islandFlag;
+	}
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->m_islandFlag = false;
+	}
+
+	if (m_threadPool)
+	{
+		SolveIslandsParallel(step);
+	}
+	else
+	{
+		SolveIslands(step);
+	}
 
 	{
 		b2Timer timer;
@@ -860,6 +1103,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
+		subStep.simdSolving = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
 		// Reset island flags and synchronize broad-phase proxies.
@@ -923,6 +1167,7 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.simdSolving = m_simdSolving;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
@@ -957,6 +1202,11 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 		ClearForces();
 	}
 
+	if (m_treeCompaction)
+	{
+		m_contactManager.m_broadPhase.Compact();
+	}
+
 	m_flags &= ~e_locked;
 
 	m_profile.step = stepTimer.GetMilliseconds();
@@ -1028,6 +1278,141 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
+// Batched queries and ray casts are split into blocks of this many items,
+// so the pool is not fed one tiny traversal at a time.
+const int32 b2_batchBlockSize = 16;
+
+struct b2WorldBatchContext
+{
+	const b2World* world;
+	b2QueryCallback* const* callbacks;
+	const b2AABB* aabbs;
+	b2RayCastHit* hits;
+	const b2Vec2* points;
+	int32 count;
+};
+
+struct b2WorldClosestRayCastWrapper
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		b2Fixture* fixture = proxy->fixture;
+		if (fixture->IsSensor())
+		{
+			return input.maxFraction;
+		}
+
+		b2RayCastOutput output;
+		bool hit = fixture->RayCast(&output, input, proxy->childIndex);
+
+		if (hit)
+		{
+			float32 fraction = output.fraction;
+			result->fixture = fixture;
+			result->point = (1.0f - fraction) * input.p1 + fraction * input.p2;
+			result->normal = output.normal;
+			result->fraction = fraction;
+			return fraction;
+		}
+
+		return input.maxFraction;
+	}
+
+	const b2BroadPhase* broadPhase;
+	b2RayCastHit* result;
+};
+
+void b2World::QueryTask(void* context, int32 index, int32 worker)
+{
+	B2_NOT_USED(worker);
+
+	b2WorldBatchContext* batch = (b2WorldBatchContext*)context;
+	int32 begin = index * b2_batchBlockSize;
+	int32 end = b2Min(begin + b2_batchBlockSize, batch->count);
+	for (int32 i = begin; i < end; ++i)
+	{
+		batch->world->QueryAABB(batch->callbacks[i], batch->aabbs[i]);
+	}
+}
+
+void b2World::QueryAABB(b2QueryCallback* const* callbacks, const b2AABB* aabbs, int32 count) const
+{
+	b2WorldBatchContext batch;
+	batch.world = this;
+	batch.callbacks = callbacks;
+	batch.aabbs = aabbs;
+	batch.count = count;
+
+	// The pool may already be busy with the step that is calling us.
+	int32 blockCount = (count + b2_batchBlockSize - 1) / b2_batchBlockSize;
+	if (m_threadPool && blockCount > 1 && IsLocked() == false)
+	{
+		m_threadPool->ParallelFor(blockCount, QueryTask, &batch);
+	}
+	else
+	{
+		for (int32 i = 0; i < blockCount; ++i)
+		{
+			QueryTask(&batch, i, 0);
+		}
+	}
+}
+
+void b2World::RayCastClosestTask(void* context, int32 index, int32 worker)
+{
+	B2_NOT_USED(worker);
+
+	b2WorldBatchContext* batch = (b2WorldBatchContext*)context;
+	const b2BroadPhase* broadPhase = &batch->world->m_contactManager.m_broadPhase;
+	int32 begin = index * b2_batchBlockSize;
+	int32 end = b2Min(begin + b2_batchBlockSize, batch->count);
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2RayCastHit* hit = batch->hits + i;
+		hit->fixture = NULL;
+		hit->point = batch->points[2 * i + 1];
+		hit->normal.SetZero();
+		hit->fraction = 1.0f;
+
+		b2RayCastInput input;
+		input.maxFraction = 1.0f;
+		input.p1 = batch->points[2 * i];
+		input.p2 = batch->points[2 * i + 1];
+		if (input.p1 == input.p2)
+		{
+			continue;
+		}
+
+		b2WorldClosestRayCastWrapper wrapper;
+		wrapper.broadPhase = broadPhase;
+		wrapper.result = hit;
+		broadPhase->RayCast(&wrapper, input);
+	}
+}
+
+void b2World::RayCastClosest(b2RayCastHit* hits, const b2Vec2* points, int32 count) const
+{
+	b2WorldBatchContext batch;
+	batch.world = this;
+	batch.hits = hits;
+	batch.points = points;
+	batch.count = count;
+
+	int32 blockCount = (count + b2_batchBlockSize - 1) / b2_batchBlockSize;
+	if (m_threadPool && blockCount > 1 && IsLocked() == false)
+	{
+		m_threadPool->ParallelFor(blockCount, RayCastClosestTask, &batch);
+	}
+	else
+	{
+		for (int32 i = 0; i < blockCount; ++i)
+		{
+			RayCastClosestTask(&batch, i, 0);
+		}
+	}
+}
+
 void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
 {
 	switch (fixture->GetType())
@@ -1256,6 +1641,43 @@ float32 b2World::GetTreeQuality() const
 	return m_contactManager.m_broadPhase.GetTreeQuality();
 }
 
+void b2World::GetAllocatorStats(b2AllocatorStats* stats) const
+{
+	stats->stackCapacity = m_stackAllocator.GetCapacity();
+	stats->stackMaxAllocation = m_stackAllocator.GetMaxAllocation();
+	stats->stackFallbacks = m_stackAllocator.GetFallbackCount();
+
+	int32 allocatorCount = GetThreadCount() - 1;
+	for (int32 i = 0; i < allocatorCount; ++i)
+	{
+		const b2StackAllocator& allocator = m_threadAllocators[i];
+		stats->stackCapacity += allocator.GetCapacity();
+		stats->stackMaxAllocation = b2Max(stats->stackMaxAllocation, allocator.GetMaxAllocation());
+		stats->stackFallbacks += allocator.GetFallbackCount();
+	}
+
+	stats->chunkCount = m_blockAllocator.GetChunkCount();
+	stats->blockCount = m_blockAllocator.GetBlockCount();
+	stats->largeAllocations = m_blockAllocator.GetLargeAllocationCount();
+}
+
+void b2World::ReserveStack(int32 size)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_stackAllocator.Reserve(size);
+
+	int32 allocatorCount = GetThreadCount() - 1;
+	for (int32 i = 0; i < allocatorCount; ++i)
+	{
+		m_threadAllocators[i].Reserve(size);
+	}
+}
+
 void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	b2Assert((m_flags & e_locked) == 0);
@@ -34,6 +34,30 @@ class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2Island;
+class b2ThreadPool;
+
+/// The closest fixture hit by a ray.
+/// See b2World::RayCastClosest
+struct b2RayCastHit
+{
+	b2Fixture* fixture;	///< the fixture hit, NULL if the ray hit nothing
+	b2Vec2 point;		///< the point of initial intersection
+	b2Vec2 normal;		///< the normal vector at the point of intersection
+	float32 fraction;	///< the fraction along the ray, 1 if the ray hit nothing
+};
+
+/// Memory used by a world's allocators.
+/// See b2World::GetAllocatorStats
+struct b2AllocatorStats
+{
+	int32 stackCapacity;		///< bytes of stack, summed over the world threads
+	int32 stackMaxAllocation;	///< most bytes allocated at once by any thread
+	int32 stackFallbacks;		///< stack allocations that did not fit and used b2Alloc
+	int32 chunkCount;			///< small object chunks, each b2_chunkSize bytes
+	int32 blockCount;			///< small objects currently allocated
+	int32 largeAllocations;		///< objects too large for a chunk, allocated with b2Alloc
+};
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -121,6 +145,22 @@ public:
 	/// @param point2 the ray ending point
 	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const;
 
+	/// Query many AABBs at once. Box i reports to callbacks[i]. The boxes are
+	/// spread over the world threads (see SetThreadCount), so a callback may be
+	/// called from any of them, but each is only ever called from one at a time.
+	/// @param callbacks one callback per box.
+	/// @param aabbs the query boxes.
+	/// @param count the number of boxes.
+	void QueryAABB(b2QueryCallback* const* callbacks, const b2AABB* aabbs, int32 count) const;
+
+	/// Ray-cast many rays at once, keeping only the closest fixture each hits.
+	/// Sensors are ignored. The rays are spread over the world threads (see
+	/// SetThreadCount).
+	/// @param hits receives one hit per ray.
+	/// @param points ray i goes from points[2 * i] to points[2 * i + 1].
+	/// @param count the number of rays.
+	void RayCastClosest(b2RayCastHit* hits, const b2Vec2* points, int32 count) const;
+
 	/// Get the world body list. With the returned body, use b2Body::GetNext to get
 	/// the next body in the world list. A NULL body indicates the end of the list.
 	/// @return the head of the world body list.
@@ -149,6 +189,22 @@ public:
 	void SetWarmStarting(bool flag) { m_warmStarting = flag; }
 	bool GetWarmStarting() const { return m_warmStarting; }
 
+	/// Enable/disable the SIMD contact velocity solver. It visits contacts in
+	/// a different order than the scalar solver, so results differ slightly.
+	void SetSimdSolving(bool flag) { m_simdSolving = flag; }
+	bool GetSimdSolving() const { return m_simdSolving; }
+
+	/// Select how the broad-phase avoids reporting a pair twice. See
+	/// b2BroadPhase::PairMode.
+	void SetPairMode(b2BroadPhase::PairMode mode) { m_contactManager.m_broadPhase.SetPairMode(mode); }
+	b2BroadPhase::PairMode GetPairMode() const { return m_contactManager.m_broadPhase.GetPairMode(); }
+
+	/// Enable/disable compacting the broad-phase tree at the end of each time
+	/// step. This speeds up QueryAABB and RayCast between steps at the cost
+	/// of a copy of the tree per step. Results are the same either way.
+	void SetTreeCompaction(bool flag) { m_treeCompaction = flag; }
+	bool GetTreeCompaction() const { return m_treeCompaction; }
+
 	/// Enable/disable continuous physics. For testing.
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 	bool GetContinuousPhysics() const { return m_continuousPhysics; }
@@ -157,6 +213,15 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Set the number of threads used for the narrow-phase and to solve
+	/// islands, including the calling thread. One (the default) runs
+	/// serially. Results are deterministic and match the serial path for
+	/// any thread count; contact listeners are always called on the
+	/// calling thread, in the same order.
+	/// @warning this must be called outside of a time step.
+	void SetThreadCount(int32 count);
+	int32 GetThreadCount() const;
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -169,6 +234,20 @@ public:
 	/// Get the number of contacts (each may have 0 or more contact points).
 	int32 GetContactCount() const;
 
+	/// Get the number of islands solved by the last time step.
+	int32 GetIslandCount() const;
+
+	/// Get the memory used by the stack and small object allocators. The
+	/// fallback and large allocation counters only go up, so a steady state
+	/// without allocations can be checked by comparing them between steps.
+	void GetAllocatorStats(b2AllocatorStats* stats) const;
+
+	/// Grow the per step stack of every world thread to at least the
+	/// given size in bytes, so even the first steps do not fall back to
+	/// b2Alloc. The stacks otherwise grow to their high-water mark.
+	/// @warning this must be called outside of a time step.
+	void ReserveStack(int32 size);
+
 	/// Get the height of the dynamic tree.
 	int32 GetTreeHeight() const;
 
@@ -205,6 +284,26 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Get the size in bytes of a snapshot of the world, for SaveSnapshot.
+	int32 GetSnapshotSize() const;
+
+	/// Save the state of the world into a snapshot of GetSnapshotSize() bytes:
+	/// the motion of every body, the broad-phase, the contacts with their
+	/// manifolds and warm starting impulses, and the joint impulses. Bodies,
+	/// fixtures and joints are referred to rather than copied, so a snapshot
+	/// can only be restored into this world while it has the same ones.
+	/// @warning this must be called outside of a time step.
+	void SaveSnapshot(void* snapshot) const;
+
+	/// Restore a snapshot saved by SaveSnapshot. Stepping from there gives the
+	/// same results as it did after the snapshot was saved. No contact
+	/// callbacks are called.
+	/// @return false, leaving the world untouched, if the snapshot does not
+	/// fit this world: it was saved by another world, bodies, fixtures or
+	/// joints were created or destroyed since, or it is damaged.
+	/// @warning this must be called outside of a time step.
+	bool RestoreSnapshot(const void* snapshot, int32 size);
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
@@ -225,14 +324,26 @@ private:
 	friend class b2Controller;
 
 	void Solve(const b2TimeStep& step);
+	void SolveIslands(const b2TimeStep& step);
+	void SolveIslandsParallel(const b2TimeStep& step);
+	void BuildIsland(b2Body* seed, b2Island* island, b2Body** stack, int32 stackSize);
+	static void SolveIslandTask(void* context, int32 index, int32 worker);
 	void SolveTOI(const b2TimeStep& step);
 
+	static void QueryTask(void* context, int32 index, int32 worker);
+	static void RayCastClosestTask(void* context, int32 index, int32 worker);
+
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
+	// Islands are solved on the pool when more than one thread is set.
+	// Worker i > 0 allocates from m_threadAllocators[i - 1].
+	b2ThreadPool* m_threadPool;
+	b2StackAllocator* m_threadAllocators;
+
 	int32 m_flags;
 
 	b2ContactManager m_contactManager;
@@ -242,6 +353,7 @@ private:
 
 	int32 m_bodyCount;
 	int32 m_jointCount;
+	int32 m_islandCount;
 
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
@@ -255,6 +367,8 @@ private:
 
 	// These are for debugging the solver.
 	bool m_warmStarting;
+	bool m_simdSolving;
+	bool m_treeCompaction;
 	bool m_continuousPhysics;
 	bool m_subStepping;
 
@@ -308,6 +422,11 @@ inline int32 b2World::GetContactCount() const
 	return m_contactManager.m_contactCount;
 }
 
+inline int32 b2World::GetIslandCount() const
+{
+	return m_islandCount;
+}
+
 inline void b2World::SetGravity(const b2Vec2& gravity)
 {
 	m_gravity = gravity;
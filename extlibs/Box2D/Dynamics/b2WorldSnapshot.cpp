@@ -0,0 +1,298 @@
+/*
+* Copyright (c) 2014 Jairo Luiz and the RubyAction contributors
+*
+* Not part of the original Box2D distribution; released under the same
+* license as Box2D.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <string.h>
+
+// A snapshot is laid out as a header, then one record per body in body list
+// order, one per joint in joint list order, the broad-phase state and one
+// record per contact. Contacts are stored oldest first, so recreating them
+// in that order rebuilds the world and body contact lists in the order the
+// solver visited them.
+//
+// Snapshots come from scripts, so nothing in them is trusted until it has
+// been checked against this world: proxies are looked up by id and their
+// user data compared with the world's own, never followed.
+
+struct b2SnapshotHeader
+{
+	int32 bodyCount;
+	int32 jointCount;
+	int32 proxyCount;
+	int32 contactCount;
+	int32 broadPhaseSize;
+	float32 inv_dt0;
+	int32 stepComplete;
+};
+
+struct b2BodySnapshot
+{
+	b2Transform xf;
+	b2Sweep sweep;
+	b2Vec2 linearVelocity;
+	float32 angularVelocity;
+	b2Vec2 force;
+	float32 torque;
+	float32 sleepTime;
+	uint16 flags;
+};
+
+struct b2ContactSnapshot
+{
+	int32 proxyIdA;
+	int32 proxyIdB;
+	uint32 flags;
+	b2Manifold manifold;
+	int32 toiCount;
+	float32 toi;
+	float32 friction;
+	float32 restitution;
+	float32 tangentSpeed;
+};
+
+// Records are copied with memcpy since the buffer has no alignment.
+template <typename T>
+inline void b2SnapshotWrite(char*& buffer, const T& value)
+{
+	memcpy(buffer, &value, sizeof(T));
+	buffer += sizeof(T);
+}
+
+template <typename T>
+inline void b2SnapshotRead(const char*& buffer, T* value)
+{
+	memcpy(value, buffer, sizeof(T));
+	buffer += sizeof(T);
+}
+
+int32 b2World::GetSnapshotSize() const
+{
+	return sizeof(b2SnapshotHeader)
+		+ m_bodyCount * sizeof(b2BodySnapshot)
+		+ m_jointCount * sizeof(b2JointState)
+		+ m_contactManager.m_broadPhase.GetStateSize()
+		+ m_contactManager.m_contactCount * sizeof(b2ContactSnapshot);
+}
+
+void b2World::SaveSnapshot(void* snapshot) const
+{
+	b2Assert(IsLocked() == false);
+
+	const b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	char* buffer = (char*)snapshot;
+
+	b2SnapshotHeader header = b2SnapshotHeader();
+	header.bodyCount = m_bodyCount;
+	header.jointCount = m_jointCount;
+	header.proxyCount = broadPhase->GetProxyCount();
+	header.contactCount = m_contactManager.m_contactCount;
+	header.broadPhaseSize = broadPhase->GetStateSize();
+	header.inv_dt0 = m_inv_dt0;
+	header.stepComplete = m_stepComplete;
+	b2SnapshotWrite(buffer, header);
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2BodySnapshot body = b2BodySnapshot();
+		body.xf = b->m_xf;
+		body.sweep = b->m_sweep;
+		body.linearVelocity = b->m_linearVelocity;
+		body.angularVelocity = b->m_angularVelocity;
+		body.force = b->m_force;
+		body.torque = b->m_torque;
+		body.sleepTime = b->m_sleepTime;
+		body.flags = b->m_flags & ~b2Body::e_islandFlag;
+		b2SnapshotWrite(buffer, body);
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		b2JointState joint;
+		j->GetState(&joint);
+		b2SnapshotWrite(buffer, joint);
+	}
+
+	broadPhase->SaveState(buffer);
+	buffer += header.broadPhaseSize;
+
+	// The contact list is newest first, so it is written back to front.
+	buffer += header.contactCount * sizeof(b2ContactSnapshot);
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		b2ContactSnapshot contact = b2ContactSnapshot();
+		contact.proxyIdA = c->m_fixtureA->m_proxies[c->m_indexA].proxyId;
+		contact.proxyIdB = c->m_fixtureB->m_proxies[c->m_indexB].proxyId;
+		contact.flags = c->m_flags & ~b2Contact::e_islandFlag;
+		contact.manifold = c->m_manifold;
+		contact.toiCount = c->m_toiCount;
+		contact.toi = c->m_toi;
+		contact.friction = c->m_friction;
+		contact.restitution = c->m_restitution;
+		contact.tangentSpeed = c->m_tangentSpeed;
+
+		buffer -= sizeof(b2ContactSnapshot);
+		memcpy(buffer, &contact, sizeof(contact));
+	}
+}
+
+bool b2World::RestoreSnapshot(const void* snapshot, int32 size)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || size < (int32)sizeof(b2SnapshotHeader))
+	{
+		return false;
+	}
+
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	const char* buffer = (const char*)snapshot;
+
+	b2SnapshotHeader header;
+	b2SnapshotRead(buffer, &header);
+
+	if (header.bodyCount != m_bodyCount || header.jointCount != m_jointCount ||
+		header.proxyCount != broadPhase->GetProxyCount() || header.broadPhaseSize < 0 || header.contactCount < 0)
+	{
+		return false;
+	}
+
+	int32 remaining = size - (int32)sizeof(b2SnapshotHeader)
+		- header.bodyCount * (int32)sizeof(b2BodySnapshot)
+		- header.jointCount * (int32)sizeof(b2JointState);
+	if (remaining < header.broadPhaseSize)
+	{
+		return false;
+	}
+
+	remaining -= header.broadPhaseSize;
+	if (header.contactCount != remaining / (int32)sizeof(b2ContactSnapshot) ||
+		remaining % (int32)sizeof(b2ContactSnapshot) != 0)
+	{
+		return false;
+	}
+
+	// The contacts are checked against the current proxies, which the
+	// broad-phase state must leave as they are.
+	const char* broadPhaseState = buffer + header.bodyCount * sizeof(b2BodySnapshot) + header.jointCount * sizeof(b2JointState);
+	const char* contacts = broadPhaseState + header.broadPhaseSize;
+	for (int32 i = 0; i < header.contactCount; ++i)
+	{
+		b2ContactSnapshot contact;
+		b2SnapshotRead(contacts, &contact);
+
+		if (broadPhase->IsProxy(contact.proxyIdA) == false || broadPhase->IsProxy(contact.proxyIdB) == false)
+		{
+			return false;
+		}
+
+		// The fixtures were saved in the order the contact factory wants them,
+		// so they must not be swapped again.
+		b2FixtureProxy* proxyA = (b2FixtureProxy*)broadPhase->GetUserData(contact.proxyIdA);
+		b2FixtureProxy* proxyB = (b2FixtureProxy*)broadPhase->GetUserData(contact.proxyIdB);
+		if (proxyA->fixture->m_body == proxyB->fixture->m_body ||
+			b2Contact::CreatesInOrder(proxyA->fixture->GetType(), proxyB->fixture->GetType()) == false)
+		{
+			return false;
+		}
+
+		// The type is read as the integer it was saved as.
+		int32 type;
+		b2Assert(sizeof(type) == sizeof(contact.manifold.type));
+		memcpy(&type, &contact.manifold.type, sizeof(type));
+		if (contact.manifold.pointCount < 0 || contact.manifold.pointCount > b2_maxManifoldPoints ||
+			type < b2Manifold::e_circles || type > b2Manifold::e_faceB)
+		{
+			return false;
+		}
+	}
+
+	// This is the last check, everything after it succeeds.
+	if (broadPhase->LoadState(broadPhaseState, header.broadPhaseSize) == false)
+	{
+		return false;
+	}
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2BodySnapshot body;
+		b2SnapshotRead(buffer, &body);
+		b->m_xf = body.xf;
+		b->m_sweep = body.sweep;
+		b->m_linearVelocity = body.linearVelocity;
+		b->m_angularVelocity = body.angularVelocity;
+		b->m_force = body.force;
+		b->m_torque = body.torque;
+		b->m_sleepTime = body.sleepTime;
+
+		// Whether a body is active decides whether it has proxies, so that
+		// is left as it is.
+		b->m_flags = (body.flags & ~b2Body::e_activeFlag) | (b->m_flags & b2Body::e_activeFlag);
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		b2JointState joint;
+		b2SnapshotRead(buffer, &joint);
+		j->SetState(joint);
+	}
+
+	buffer += header.broadPhaseSize;
+
+	// Destroy the current contacts without telling the listener they ended.
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	m_contactManager.m_contactListener = NULL;
+	while (m_contactManager.m_contactList)
+	{
+		m_contactManager.Destroy(m_contactManager.m_contactList);
+	}
+	m_contactManager.m_contactListener = listener;
+
+	for (int32 i = 0; i < header.contactCount; ++i)
+	{
+		b2ContactSnapshot contact;
+		b2SnapshotRead(buffer, &contact);
+
+		b2FixtureProxy* proxyA = (b2FixtureProxy*)broadPhase->GetUserData(contact.proxyIdA);
+		b2FixtureProxy* proxyB = (b2FixtureProxy*)broadPhase->GetUserData(contact.proxyIdB);
+		b2Contact* c = m_contactManager.Create(proxyA->fixture, proxyA->childIndex, proxyB->fixture, proxyB->childIndex);
+		if (c == NULL)
+		{
+			continue;
+		}
+
+		b2Assert(c->m_fixtureA == proxyA->fixture);
+
+		c->m_flags = contact.flags;
+		c->m_manifold = contact.manifold;
+		c->m_toiCount = contact.toiCount;
+		c->m_toi = contact.toi;
+		c->m_friction = contact.friction;
+		c->m_restitution = contact.restitution;
+		c->m_tangentSpeed = contact.tangentSpeed;
+	}
+
+	m_inv_dt0 = header.inv_dt0;
+	m_stepComplete = header.stepComplete != 0;
+	return true;
+}
@@ -0,0 +1,68 @@
+# Builds mruby from a source checkout with its own minirake, which needs ruby and bison on the host.
+#
+#   mruby_build(<target> BOXING <NO|NAN|WORD> HEAP_PAGE_SIZE <objects> IV_SEGLIST <ON|OFF>)
+#
+# defines <target> as an imported static library. The value representation changes the layout of mrb_value,
+# so the definitions mruby was built with are carried by the target to everything linking it.
+#
+# MRUBY_SOURCE_DIR has to be the mruby revision whose headers are vendored in extlibs/mruby.
+
+include(ExternalProject)
+include(CMakeParseArguments)
+
+set(MRUBY_SOURCE_DIR "" CACHE PATH "mruby source checkout, with minirake at its root")
+find_program(RUBY_EXECUTABLE ruby)
+
+function(mruby_build target)
+  cmake_parse_arguments(MRUBY "" "BOXING;HEAP_PAGE_SIZE;IV_SEGLIST" "" ${ARGN})
+
+  if(CMAKE_VERSION VERSION_LESS 3.3)
+    message(FATAL_ERROR "Building mruby from source needs CMake 3.3 or later")
+  endif()
+  if(NOT EXISTS ${MRUBY_SOURCE_DIR}/minirake)
+    message(FATAL_ERROR "MRUBY_SOURCE_DIR must point to an mruby checkout (no minirake in '${MRUBY_SOURCE_DIR}')")
+  endif()
+  if(NOT RUBY_EXECUTABLE)
+    message(FATAL_ERROR "Building mruby from source needs ruby")
+  endif()
+
+  set(definitions MRB_HEAP_PAGE_SIZE=${MRUBY_HEAP_PAGE_SIZE})
+  if(MRUBY_BOXING STREQUAL "NAN")
+    list(APPEND definitions MRB_NAN_BOXING)
+  elseif(MRUBY_BOXING STREQUAL "WORD")
+    list(APPEND definitions MRB_WORD_BOXING)
+  elseif(NOT MRUBY_BOXING STREQUAL "NO")
+    message(FATAL_ERROR "mruby boxing must be NO, NAN or WORD, not '${MRUBY_BOXING}'")
+  endif()
+  if(MRUBY_IV_SEGLIST)
+    list(APPEND definitions MRB_USE_IV_SEGLIST)
+  endif()
+
+  set(build_dir ${CMAKE_CURRENT_BINARY_DIR}/${target})
+  set(library ${build_dir}/lib/${CMAKE_STATIC_LIBRARY_PREFIX}mruby${CMAKE_STATIC_LIBRARY_SUFFIX})
+  string(REPLACE ";" " " defines "${definitions}")
+  file(WRITE ${build_dir}/build_config.rb
+    "MRuby::Build.new do |conf|\n"
+    "  toolchain :gcc\n"
+    "  conf.gembox 'default'\n"
+    "  conf.cc.defines += %w(${defines})\n"
+    "  conf.build_dir = '${build_dir}'\n"
+    "end\n"
+  )
+
+  ExternalProject_Add(${target}_build
+    SOURCE_DIR ${MRUBY_SOURCE_DIR}
+    BUILD_IN_SOURCE 1
+    CONFIGURE_COMMAND ""
+    BUILD_COMMAND ${CMAKE_COMMAND} -E env MRUBY_CONFIG=${build_dir}/build_config.rb ${RUBY_EXECUTABLE} ./minirake
+    BUILD_ALWAYS 1
+    BUILD_BYPRODUCTS ${library}
+    INSTALL_COMMAND ""
+  )
+
+  add_library(${target} STATIC IMPORTED)
+  set_property(TARGET ${target} PROPERTY IMPORTED_LOCATION ${library})
+  set_property(TARGET ${target} PROPERTY INTERFACE_COMPILE_DEFINITIONS ${definitions})
+  set_property(TARGET ${target} PROPERTY INTERFACE_LINK_LIBRARIES m)
+  add_dependencies(${target} ${target}_build)
+endfunction()
@@ -1,29 +1,50 @@
 #ifndef __APPLICATION__
 #define __APPLICATION__
 
+#include "util/histogram.hpp"
 #include <SFML/Graphics.hpp>
 
 namespace RubyAction
 {
 
+  class RenderThread;
+
   class Application
   {
   private:
     static Application *instance;
-    Application() {}
+    RenderThread *renderThread;
+    sf::Clock frameClock;
+    sf::Time nextFrame;
+    sf::Time lastActive;
+    RollingHistogram frameTimes;
+    Application() : renderThread(NULL), frameTimes(600), window(NULL) {}
+    void waitForNextFrame(bool);
 
   public:
     sf::RenderWindow *window;
     static Application* getInstance();
     int run(const char *);
+    void close();
+    void setVerticalSync(bool);
+    mrb_value getFrameTimes(mrb_state*);
 
     struct {
       int width = 800;
       int height = 600;
       const char *title = "RubyAction";
+      bool renderThread = false;
+      bool vsync = false;
+      // frames per second, 0 for as fast as possible
+      int targetFps = 0;
+      // frames per second once nothing has changed for idleDelay seconds, 0 to never slow down
+      int idleFps = 0;
+      float idleDelay = 1;
     } config;
   };
 
+  void bindApplication(mrb_state*, RClass*);
+
 }
 
 #endif // __APPLICATION__
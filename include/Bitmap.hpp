@@ -2,14 +2,17 @@
 #define __BITMAP__
 
 #include "Sprite.hpp"
+#include "TextureRegion.hpp"
 
 namespace RubyAction
 {
 
   class Bitmap : public Sprite
   {
+  private:
+    TextureRegion *region;
   protected:
-    virtual void renderMe(sf::RenderTarget *);
+    virtual bool renderMe(sf::RenderTarget *, const sf::Transform&);
   public:
     Bitmap(mrb_value, mrb_value);
   };
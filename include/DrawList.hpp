@@ -0,0 +1,49 @@
+#ifndef __DRAW_LIST__
+#define __DRAW_LIST__
+
+#include "RubyObject.hpp"
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <utility>
+
+namespace RubyAction
+{
+
+  // A flat list of the draws of a frame, recorded on the main thread and submitted by the render thread.
+  // Vertices are transformed when they are recorded, so consecutive draws of the same texture and primitive
+  // type are submitted as one. The Ruby objects owning the textures are kept so they outlive the submission.
+  class DrawList
+  {
+  private:
+    static DrawList *recording;
+
+    struct Command
+    {
+      const sf::Texture *texture;
+      sf::PrimitiveType type;
+      size_t first;
+      size_t count;
+      int text;
+    };
+
+    std::vector<sf::Vertex> vertices;
+    std::vector<Command> commands;
+    std::vector<std::pair<sf::Text, sf::Transform> > texts;
+    std::vector<RubyObject*> owners;
+
+    Command& append(RubyObject*, const sf::Texture*, sf::PrimitiveType);
+  public:
+    static DrawList* getRecording();
+    void begin();
+    void end();
+    void addQuad(RubyObject*, const sf::Texture&, const sf::Transform&, const sf::IntRect&, const sf::Color&);
+    void addVertices(RubyObject*, const sf::Texture*, const sf::Transform&, const sf::VertexArray&);
+    void addText(RubyObject*, const sf::Text&, const sf::Transform&);
+    mrb_value getOwners(mrb_state*);
+    bool draws(RubyObject*) const;
+    void submit(sf::RenderTarget&);
+  };
+
+}
+
+#endif // __DRAW_LIST__
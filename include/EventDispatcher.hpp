@@ -13,6 +13,7 @@ namespace RubyAction
     void on(mrb_sym, mrb_value);
     void off(mrb_sym);
     void off();
+    bool hasListener(mrb_sym);
     virtual void dispatch(mrb_sym, mrb_value* = NULL, int = 0);
   };
 
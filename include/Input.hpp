@@ -0,0 +1,36 @@
+#ifndef __INPUT__
+#define __INPUT__
+
+#include <mruby.h>
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace RubyAction
+{
+
+  // The state of the keyboard and mouse as of the last polled events, so scripts can query it at any time
+  // instead of following every key and mouse event.
+  class Input
+  {
+  private:
+    static bool keys[sf::Keyboard::KeyCount];
+    static bool buttons[sf::Mouse::ButtonCount];
+    static sf::Vector2i mousePosition;
+    static std::vector<int> mouseMoves;
+  public:
+    static bool mouseHistory;
+    static void setKey(int, bool);
+    static bool isKeyDown(int);
+    static void setButton(int, bool);
+    static bool isButtonDown(int);
+    static void moveMouse(int, int);
+    static const sf::Vector2i& getMousePosition();
+    static bool takeMouseMoves(std::vector<int>&);
+    static void releaseAll();
+  };
+
+  void bindInput(mrb_state*, RClass*);
+
+}
+
+#endif // __INPUT__
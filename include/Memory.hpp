@@ -0,0 +1,60 @@
+#ifndef __MEMORY__
+#define __MEMORY__
+
+#include <mruby.h>
+#include <cstddef>
+#include <vector>
+
+namespace RubyAction
+{
+
+  // Serves every allocation of the interpreter. Blocks up to 512 bytes come from free lists of power of two
+  // size classes, carved out of chunks that are kept until the interpreter is closed; larger ones go to the
+  // system. An mrb_state is only ever used by one thread at a time, so the size classes belong to the state
+  // and need no locking. With a limit set, an allocation that would exceed it fails; mruby then collects
+  // garbage and tries once more, raising an error if it fails again.
+  class Memory
+  {
+  public:
+    static const int CLASSES = 6;
+
+    struct Stats
+    {
+      size_t blocks;
+      size_t bytes;
+      size_t allocations;
+    };
+
+  private:
+    struct Block
+    {
+      Block *next;
+    };
+
+    Block *freeLists[CLASSES];
+    std::vector<char*> chunks;
+    Stats classes[CLASSES + 1];
+    size_t bytes;
+    size_t peak;
+    size_t limit;
+    size_t failures;
+
+    static int classOf(size_t);
+    bool reserve(size_t);
+    void* allocate(size_t);
+    void* reallocate(void*, size_t);
+    void release(void*);
+  public:
+    Memory();
+    ~Memory();
+    static void* allocf(mrb_state*, void*, size_t, void*);
+    size_t getLimit();
+    void setLimit(size_t);
+    mrb_value getStats(mrb_state*);
+  };
+
+  void bindMemory(mrb_state*, RClass*);
+
+}
+
+#endif // __MEMORY__
@@ -12,10 +12,21 @@ namespace RubyAction
   private:
     sf::RenderTexture texture;
     sf::Sprite sprite;
+    bool batching;
+    bool lazy;
+    bool dirty;
+    void flush();
   public:
     RenderTarget(mrb_value self, float, float);
+    void begin();
+    void end();
+    bool isBatching();
     void draw(Sprite*);
     void clear();
+    bool isLazy();
+    void setLazy(bool);
+    void resolve();
+    virtual const sf::Texture& getTexture();
     virtual void render(sf::RenderTarget&, const sf::Transform&, const sf::IntRect&, const sf::Color&);
   };
 
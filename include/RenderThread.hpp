@@ -0,0 +1,46 @@
+#ifndef __RENDER_THREAD__
+#define __RENDER_THREAD__
+
+#include "DrawList.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace RubyAction
+{
+
+  // Clears the window, submits a recorded draw list and displays it on a thread of its own, so presenting a
+  // frame overlaps with scripting the next one. The lists are double buffered: the main thread records into
+  // one while the other is submitted.
+  class RenderThread
+  {
+  private:
+    static RenderThread *instance;
+
+    sf::RenderWindow *window;
+    sf::Color clearColor;
+    DrawList lists[2];
+    DrawList *submitting;
+    int back;
+    int vsync;
+    bool stopping;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    void run();
+    void wait(RubyObject*);
+  public:
+    RenderThread(sf::RenderWindow*, const sf::Color&);
+    ~RenderThread();
+    DrawList* record();
+    void present();
+    void wait();
+    void setVerticalSync(bool);
+    static void sync(RubyObject*);
+  };
+
+}
+
+#endif // __RENDER_THREAD__
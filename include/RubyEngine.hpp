@@ -8,6 +8,7 @@
 #include <mruby/class.h>
 #include <mruby/string.h>
 #include <mruby/variable.h>
+#include "Memory.hpp"
 
 namespace RubyAction
 {
@@ -17,6 +18,7 @@ namespace RubyAction
   private:
     typedef void (*bindFunction)(mrb_state*, RClass*);
     static RubyEngine *instance;
+    Memory memory;
     mrb_state *mrb;
     RClass *module;
     RubyEngine();
@@ -22,8 +22,22 @@ namespace RubyAction
     bool visible;
     sf::Color color;
     sf::Transform transform;
+    sf::FloatRect worldBounds;
+    sf::FloatRect worldSubtreeBounds;
+    bool cullChildren;
+    bool boundsDirty;
+    bool transformDirty;
+    bool worldSubtreeDirty;
+    sf::FloatRect subtreeBounds;
+    void invalidateBounds();
+    void invalidateTransform();
+    void invalidateWorldTransform();
+    sf::Transform getLocalTransform();
   protected:
-    virtual void renderMe(sf::RenderTarget*) {};
+    // Draws the sprite itself with its world transform, and returns whether anything was drawn.
+    virtual bool renderMe(sf::RenderTarget*, const sf::Transform&) { return false; };
+    virtual sf::FloatRect getContentBounds();
+    static sf::FloatRect getViewport(sf::RenderTarget*);
     const sf::Transform& getTransform();
   public:
     Sprite(mrb_value);
@@ -47,6 +61,9 @@ namespace RubyAction
     void setRotation(float);
     bool isVisible();
     void setVisible(bool);
+    bool isCullingChildren();
+    void setCullChildren(bool);
+    const sf::FloatRect& getSubtreeBounds();
     Sprite* getParent();
     void setParent(Sprite*);
     void setColor(sf::Color color);
@@ -60,6 +77,17 @@ namespace RubyAction
     void localToGlobal(float x, float y, float* gx, float* gy);
     bool collide(float gx, float gy);
     virtual void render(sf::RenderTarget*);
+    struct RenderStats
+    {
+      int drawn;
+      int culled;
+    };
+    static RenderStats renderStats;
+    static RenderStats lastRenderStats;
+    static void resetRenderStats();
+    // Set whenever something that is drawn changes, and cleared by the application every frame to tell
+    // when nothing is animating.
+    static bool changed;
     virtual void dispatch(mrb_sym, mrb_value* = NULL, int = 0);
   };
 
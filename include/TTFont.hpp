@@ -2,6 +2,8 @@
 #define __TTFONT__
 
 #include "FontBase.hpp"
+#include <bitset>
+#include <string>
 
 namespace RubyAction
 {
@@ -11,6 +13,10 @@ namespace RubyAction
   private:
     sf::Font font;
     sf::Text text;
+    std::string string;
+    std::bitset<256> laidOut;
+
+    bool addsGlyphs(const char*);
   public:
     TTFont(mrb_value, const char *, int);
     virtual void render(sf::RenderTarget&, const sf::Transform&, const sf::IntRect&, const sf::Color&, const char *);
@@ -2,6 +2,7 @@
 #define __TEXT_FIELD__
 
 #include "Sprite.hpp"
+#include "FontBase.hpp"
 #include <string>
 #include <SFML/Graphics.hpp>
 
@@ -11,9 +12,10 @@ namespace RubyAction
   class TextField : public Sprite
   {
   private:
+    FontBase *font;
     std::string text;
   protected:
-    virtual void renderMe(sf::RenderTarget *);
+    virtual bool renderMe(sf::RenderTarget *, const sf::Transform&);
   public:
     TextField(mrb_value, mrb_value, const char *);
     void setText(const char *);
@@ -13,6 +13,7 @@ namespace RubyAction
     sf::Sprite sprite;
   public:
     Texture(mrb_value self, const char *filename);
+    virtual const sf::Texture& getTexture();
     virtual void render(sf::RenderTarget&, const sf::Transform&, const sf::IntRect&, const sf::Color&);
   };
 
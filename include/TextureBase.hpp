@@ -16,6 +16,7 @@ namespace RubyAction
     TextureBase(mrb_value);
     int getWidth();
     int getHeight();
+    virtual const sf::Texture& getTexture() = 0;
     virtual void render(sf::RenderTarget&, const sf::Transform&, const sf::IntRect&, const sf::Color&) = 0;
   };
 
@@ -9,12 +9,13 @@ namespace RubyAction
   class TextureRegion : public RubyObject
   {
   protected:
+    TextureBase *textureBase;
     int x;
     int y;
     int width;
     int height;
   public:
-    TextureRegion(mrb_value, int, int, int, int);
+    TextureRegion(mrb_value, mrb_value, int, int, int, int);
     int getX();
     int getY();
     int getWidth();
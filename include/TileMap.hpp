@@ -0,0 +1,51 @@
+#ifndef __TILE_MAP__
+#define __TILE_MAP__
+
+#include "Sprite.hpp"
+#include "TextureRegion.hpp"
+#include <vector>
+
+namespace RubyAction
+{
+
+  class TileMap : public Sprite
+  {
+  private:
+    static const int CHUNK_SIZE = 32;
+
+    struct Chunk
+    {
+      sf::VertexArray vertices;
+      bool dirty;
+    };
+
+    TextureRegion *tileset;
+    int tileWidth;
+    int tileHeight;
+    int columns;
+    int rows;
+    int chunkColumns;
+    int chunkRows;
+    std::vector<int> tiles;
+    std::vector<Chunk> chunks;
+    sf::Color builtColor;
+
+    void invalidateChunk(int, int);
+    void invalidateChunks();
+    void buildChunk(int, int);
+  protected:
+    virtual bool renderMe(sf::RenderTarget *, const sf::Transform&);
+  public:
+    TileMap(mrb_value, mrb_value, int, int, int, int);
+    int getColumns();
+    int getRows();
+    int getTile(int, int);
+    void setTile(int, int, int);
+    void setTiles(const std::vector<int>&);
+  };
+
+  void bindTileMap(mrb_state*, RClass*);
+
+}
+
+#endif // __TILE_MAP__
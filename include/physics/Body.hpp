@@ -1,7 +1,8 @@
 #ifndef __PHYSICS_BODY__
 #define __PHYSICS_BODY__
 
-#include "RubyObject.hpp"
+#include "EventDispatcher.hpp"
+#include "Sprite.hpp"
 #include <mruby.h>
 #include <Box2D/Box2D.h>
 
@@ -17,12 +18,25 @@ namespace Physics
     DYNAMIC_BODY
   };
 
-  class Body : public RubyObject
+  class Fixture;
+  class FixtureDef;
+
+  class Body : public EventDispatcher
   {
   private:
     b2Body* body;
+    Sprite* sprite;
+    b2Vec2 previousPosition;
+    float32 previousAngle;
   public:
-    Body(b2World*, mrb_value);
+    Body(b2World*, const b2BodyDef&);
+    static void readDef(mrb_state*, mrb_value, b2BodyDef*);
+    b2Body* getBody();
+    Fixture* createFixture(const FixtureDef&);
+    Sprite* getSprite();
+    void setSprite(mrb_value);
+    void saveTransform();
+    void syncSprite(float, float);
   };
 
   void bindBody(mrb_state*, RClass*, RClass*);
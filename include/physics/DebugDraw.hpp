@@ -0,0 +1,55 @@
+#ifndef __PHYSICS_DEBUG_DRAW__
+#define __PHYSICS_DEBUG_DRAW__
+
+#include <SFML/Graphics.hpp>
+#include <Box2D/Box2D.h>
+#include <vector>
+
+namespace RubyAction
+{
+namespace Physics
+{
+
+  // Draws a world into two vertex arrays, one of lines and one of triangles, rendered over the stage at the
+  // end of the frame. Every instance is rendered by renderAll, so a world only has one while it is enabled.
+  // A pipelined world is being stepped while the frame renders, so it collects its drawing between steps.
+  class DebugDraw : public b2Draw
+  {
+  private:
+    static std::vector<DebugDraw*> instances;
+
+    b2World* world;
+    float scale;
+    bool pipelined;
+    sf::VertexArray lines;
+    sf::VertexArray triangles;
+
+    sf::Vector2f toPixels(const b2Vec2&);
+    void addLine(const b2Vec2&, const b2Vec2&, const sf::Color&);
+    void addTriangle(const b2Vec2&, const b2Vec2&, const b2Vec2&, const sf::Color&);
+    void drawContacts();
+    void render(sf::RenderTarget*);
+  public:
+    // Not drawn by b2World::DrawDebugData, so it is picked outside of the b2Draw bits.
+    static const uint32 e_contactBit = 0x0100;
+
+    DebugDraw(b2World*);
+    virtual ~DebugDraw();
+    void setScale(float);
+    void setPipelined(bool);
+    void collect();
+    static void renderAll(sf::RenderTarget*);
+
+    // b2Draw
+    virtual void DrawPolygon(const b2Vec2*, int32, const b2Color&);
+    virtual void DrawSolidPolygon(const b2Vec2*, int32, const b2Color&);
+    virtual void DrawCircle(const b2Vec2&, float32, const b2Color&);
+    virtual void DrawSolidCircle(const b2Vec2&, float32, const b2Vec2&, const b2Color&);
+    virtual void DrawSegment(const b2Vec2&, const b2Vec2&, const b2Color&);
+    virtual void DrawTransform(const b2Transform&);
+  };
+
+}
+}
+
+#endif // __PHYSICS_DEBUG_DRAW__
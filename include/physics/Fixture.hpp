@@ -0,0 +1,56 @@
+#ifndef __PHYSICS_FIXTURE__
+#define __PHYSICS_FIXTURE__
+
+#include "RubyObject.hpp"
+#include <mruby.h>
+#include <Box2D/Box2D.h>
+
+namespace RubyAction
+{
+namespace Physics
+{
+
+  class Body;
+
+  enum ShapeType
+  {
+    CIRCLE_SHAPE,
+    POLYGON_SHAPE,
+    EDGE_SHAPE,
+    CHAIN_SHAPE
+  };
+
+  // A fixture description read once from a Ruby hash, so it can be attached to many bodies.
+  class FixtureDef
+  {
+  private:
+    b2CircleShape circle;
+    b2PolygonShape polygon;
+    b2EdgeShape edge;
+    b2ChainShape chain;
+    FixtureDef(const FixtureDef&);
+    FixtureDef& operator=(const FixtureDef&);
+  public:
+    b2FixtureDef def;
+    // Raises for a hash the constructor can't read. Call it before the FixtureDef exists, as its
+    // constructor must not raise: a raise longjmps past the destructors of the shapes.
+    static void check(mrb_state*, mrb_value);
+    FixtureDef(mrb_state*, mrb_value);
+  };
+
+  class Fixture : public RubyObject
+  {
+  private:
+    b2Fixture* fixture;
+  public:
+    Fixture(Body*, const FixtureDef&);
+    b2Fixture* getFixture();
+    Body* getBody();
+  };
+
+  void bindFixture(mrb_state*, RClass*, RClass*);
+
+}
+}
+
+#endif // __PHYSICS_FIXTURE__
@@ -0,0 +1,40 @@
+#ifndef __PHYSICS_JOINT__
+#define __PHYSICS_JOINT__
+
+#include "RubyObject.hpp"
+#include <mruby.h>
+#include <Box2D/Box2D.h>
+
+namespace RubyAction
+{
+namespace Physics
+{
+
+  enum JointType
+  {
+    DISTANCE_JOINT,
+    REVOLUTE_JOINT,
+    PRISMATIC_JOINT,
+    WELD_JOINT,
+    WHEEL_JOINT,
+    ROPE_JOINT
+  };
+
+  class Joint : public RubyObject
+  {
+  private:
+    b2Joint* joint;
+  public:
+    // Raises for a hash the constructor can't read, including bodies that are the same or not
+    // in the world. Call it first, so a joint is only made and wrapped for a valid hash.
+    static void check(mrb_state*, b2World*, mrb_value);
+    Joint(b2World*, mrb_value);
+    b2Joint* getJoint();
+  };
+
+  void bindJoint(mrb_state*, RClass*, RClass*);
+
+}
+}
+
+#endif // __PHYSICS_JOINT__
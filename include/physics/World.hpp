@@ -3,6 +3,16 @@
 
 #include "EventDispatcher.hpp"
 #include "physics/Body.hpp"
+#include "physics/Fixture.hpp"
+#include "physics/Joint.hpp"
+#include "physics/DebugDraw.hpp"
+#include "util/histogram.hpp"
+#include <vector>
+#include <utility>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace RubyAction
 {
@@ -16,21 +26,114 @@ namespace Physics
   private:
     b2World* world;
     mrb_value raycastCallback;
+    float pixelsPerMeter;
+
+    float fixedTimeStep;
+    int fixedVelocityIterations;
+    int fixedPositionIterations;
+    int maxSubsteps;
+    float accumulator;
+    std::vector<char> snapshotBuffer;
+    RollingHistogram stepTimes;
+    DebugDraw* debugDraw;
+
+    // pipelined stepping, see advancePipelined
+    static std::vector<World*> pipelinedWorlds;
+    std::thread stepper;
+    std::mutex stepMutex;
+    std::condition_variable stepWake;
+    std::condition_variable stepDone;
+    int pendingSteps;
+    bool stepping;
+    bool stopping;
+    float pendingAlpha;
+
+    struct Contact
+    {
+      bool begin;
+      Body* bodyA;
+      Body* bodyB;
+      Fixture* fixtureA;
+      Fixture* fixtureB;
+      b2Vec2 normal;
+      b2Vec2 point;
+      float32 impulse;
+    };
+    std::vector<Contact> contacts;
+    std::vector<std::pair<b2Contact*, size_t> > begunContacts;
+    bool begunContactsSorted;
+
+    struct QueryCollector : public b2QueryCallback
+    {
+      std::vector<b2Fixture*> fixtures;
+
+      virtual bool ReportFixture(b2Fixture* fixture)
+      {
+        fixtures.push_back(fixture);
+        return true;
+      }
+    };
+
+    typedef std::vector<std::unique_ptr<FixtureDef> > FixtureDefs;
+    void readFixtureDefs(mrb_value, FixtureDefs&);
+    Body* createBody(const b2BodyDef&, const FixtureDefs&);
+    void saveTransforms();
+    void simulate(float, int, int);
+    static void simulateTask(void*, int32, int32);
+    void bufferContact(b2Contact*, bool);
+    void deliverContacts();
+    int advancePipelined(float);
+    void runSteps(int);
+    void runStepper();
+    void stopStepper();
   public:
-    World(mrb_value, int, int, bool);
+    World(mrb_value, int, int, bool, int);
     virtual ~World();
     void clearForces();
     Body* createBody(mrb_value);
+    mrb_value createBodies(mrb_value, mrb_value);
+    Joint* createJoint(mrb_value);
     int* getGravity();
     void setGravity(int, int);
     void raycast(int, int, int, int, mrb_value);
+    mrb_value raycastClosest(mrb_value);
+    mrb_value queryAABBs(mrb_value);
     void step(float, int, int);
+    static void stepAll(const std::vector<World*>&, float, int, int);
+    void setFixedStep(float, int, int, int);
+    int advance(float);
+    float getAlpha();
+    mrb_value snapshot();
+    bool restore(const char*, size_t);
+    mrb_value getProfile();
+    mrb_value getStats();
+    mrb_value getStepHistogram();
+    mrb_value getAllocatorStats();
+    void reserveStack(int);
+    int getDebugDraw();
+    void setDebugDraw(int);
+    float getPixelsPerMeter();
+    void setPixelsPerMeter(float);
+    int getThreads();
+    void setThreads(int);
+    bool isSimd();
+    void setSimd(bool);
+    int getPairMode();
+    void setPairMode(int);
+    bool isCompactTree();
+    void setCompactTree(bool);
+    bool isPipelined();
+    void setPipelined(bool);
+    void sync();
+    static void sync(b2World*);
+    void syncSprites(float);
 
     // Box2D callbacks
 
     // b2ContactListener
     virtual void BeginContact(b2Contact*);
     virtual void EndContact(b2Contact*);
+    virtual void PostSolve(b2Contact*, const b2ContactImpulse*);
 
     // b2RayCastCallback
     virtual float32 ReportFixture(b2Fixture*, const b2Vec2&, const b2Vec2&, float32);
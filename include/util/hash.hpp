@@ -3,5 +3,6 @@
 
 #define H_GET_VALUE(hash, key) mrb_hash_get(mrb, hash, mrb_symbol_value(mrb_intern(mrb, key)))
 #define H_GET_VALUE_DEF(hash, key, def) mrb_hash_fetch(mrb, hash, mrb_symbol_value(mrb_intern(mrb, key)), def)
+#define H_SET_VALUE(hash, key, value) mrb_hash_set(mrb, hash, mrb_symbol_value(mrb_intern(mrb, key)), value)
 
 #endif // __UTIL_HASH__
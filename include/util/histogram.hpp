@@ -0,0 +1,109 @@
+#ifndef __UTIL_HISTOGRAM__
+#define __UTIL_HISTOGRAM__
+
+#include "util/hash.hpp"
+#include <mruby.h>
+#include <mruby/array.h>
+#include <mruby/hash.h>
+#include <algorithm>
+#include <vector>
+
+namespace RubyAction
+{
+
+  // Keeps the last `window` timings, in milliseconds, counted into power of two buckets from 0.25 ms up to
+  // 64 ms and over, and answers percentiles over them.
+  class RollingHistogram
+  {
+  public:
+    static const int BUCKETS = 10;
+
+  private:
+    std::vector<float> samples;
+    size_t window;
+    size_t next;
+    int counts[BUCKETS];
+
+    static int bucketOf(float sample)
+    {
+      int bucket = 0;
+      for (float bound = 0.25f; bucket < BUCKETS - 1 && sample >= bound; bound *= 2) bucket++;
+      return bucket;
+    }
+
+  public:
+    RollingHistogram(size_t window)
+      : window(window),
+        next(0)
+    {
+      samples.reserve(window);
+      std::fill(counts, counts + BUCKETS, 0);
+    }
+
+    void add(float sample)
+    {
+      if (samples.size() < window)
+      {
+        samples.push_back(sample);
+      }
+      else
+      {
+        counts[bucketOf(samples[next])]--;
+        samples[next] = sample;
+      }
+      counts[bucketOf(sample)]++;
+      next = (next + 1) % window;
+    }
+
+    void clear()
+    {
+      samples.clear();
+      next = 0;
+      std::fill(counts, counts + BUCKETS, 0);
+    }
+
+    // Returns { count:, mean:, max:, p50:, p90:, p99:, buckets: [[upper bound, count], ...] }, the last
+    // upper bound being nil.
+    mrb_value toHash(mrb_state *mrb) const
+    {
+      std::vector<float> sorted(samples);
+      std::sort(sorted.begin(), sorted.end());
+
+      float sum = 0;
+      for (size_t i = 0; i < sorted.size(); i++) sum += sorted[i];
+
+      mrb_value hash = mrb_hash_new(mrb);
+      H_SET_VALUE(hash, "count", mrb_fixnum_value(sorted.size()));
+      H_SET_VALUE(hash, "mean", mrb_float_value(mrb, sorted.empty() ? 0 : sum / sorted.size()));
+      H_SET_VALUE(hash, "max", mrb_float_value(mrb, sorted.empty() ? 0 : sorted.back()));
+      H_SET_VALUE(hash, "p50", mrb_float_value(mrb, percentile(sorted, 0.5f)));
+      H_SET_VALUE(hash, "p90", mrb_float_value(mrb, percentile(sorted, 0.9f)));
+      H_SET_VALUE(hash, "p99", mrb_float_value(mrb, percentile(sorted, 0.99f)));
+
+      mrb_value buckets = mrb_ary_new_capa(mrb, BUCKETS);
+      float bound = 0.25f;
+      for (int i = 0; i < BUCKETS; i++, bound *= 2)
+      {
+        mrb_value bucket[] = {
+          i < BUCKETS - 1 ? mrb_float_value(mrb, bound) : mrb_nil_value(),
+          mrb_fixnum_value(counts[i])
+        };
+        mrb_ary_push(mrb, buckets, mrb_ary_new_from_values(mrb, 2, bucket));
+      }
+      H_SET_VALUE(hash, "buckets", buckets);
+      return hash;
+    }
+
+  private:
+    // Nearest rank percentile of sorted samples.
+    static float percentile(const std::vector<float>& sorted, float fraction)
+    {
+      if (sorted.empty()) return 0;
+      size_t rank = (size_t) (fraction * sorted.size());
+      return sorted[std::min(rank, sorted.size() - 1)];
+    }
+  };
+
+}
+
+#endif // __UTIL_HISTOGRAM__
@@ -2,6 +2,7 @@
 #define __RUBY_ACTION_WRAPPER_HPP__
 
 #include "RubyObject.hpp"
+#include <new>
 
 namespace RubyAction
 {
@@ -27,9 +28,13 @@ namespace RubyAction
 
   static void wrap(mrb_value value, RubyObject* object)
   {
+    mrb_state *mrb = RubyEngine::getInstance()->getState();
+    // allocated by the interpreter, which frees it with mrb_free; before the old wrapper is
+    // freed, as mrb_malloc raises past Memory.limit and DATA_PTR must not be left dangling
+    void *memory = mrb_malloc(mrb, sizeof(RubyObjectWrapper));
     RubyObjectWrapper *wrapper = (RubyObjectWrapper*) DATA_PTR(value);
-    if (wrapper) freeRubyObject(RubyEngine::getInstance()->getState(), wrapper);
-    DATA_PTR(value) = new RubyObjectWrapper(object);
+    if (wrapper) freeRubyObject(mrb, wrapper);
+    DATA_PTR(value) = new (memory) RubyObjectWrapper(object);
     DATA_TYPE(value) = &RubyObjectBinding;
   }
 
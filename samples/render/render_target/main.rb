@@ -8,6 +8,7 @@ crate.anchor = [0.5, 0.5]
 
 # render target
 rt = RubyAction::RenderTarget.new 800, 600
+rt.lazy = true
 
 # bitmap
 bitmap = RubyAction::Bitmap.new rt
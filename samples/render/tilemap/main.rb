@@ -0,0 +1,19 @@
+# tileset: the background image cut into 32x32 tiles
+tileset = RubyAction::TextureRegion.new RubyAction::Texture.new "../render_target/background.jpg"
+tiles_per_row = tileset.region[2] / 32
+tile_count = tiles_per_row * (tileset.region[3] / 32)
+
+# a 1000x1000 map, drawn as a handful of chunks
+tiles = Array.new(1000 * 1000) { |i| (i % 7 == 0) ? 0 : (i % tile_count) + 1 }
+map = RubyAction::TileMap.new tileset, 32, 32, 1000, 1000, tiles
+RubyAction::Stage << map
+
+RubyAction::Stage.on :enter_frame do |dt|
+  map.x -= dt * 120
+  map.y -= dt * 80
+
+  # edit a tile under the view every frame; only its chunk is rebuilt
+  column = (-map.x / 32).to_i + 5
+  row = (-map.y / 32).to_i + 5
+  map[column, row] = 1
+end
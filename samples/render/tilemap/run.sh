@@ -0,0 +1,3 @@
+#!/bin/bash
+
+../../../build/action main.rb
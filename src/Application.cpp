@@ -6,30 +6,56 @@
 #include "Sprite.hpp"
 #include "Bitmap.hpp"
 #include "TextureRegion.hpp"
+#include "TileMap.hpp"
 #include "Stage.hpp"
 #include "FontBase.hpp"
 #include "Font.hpp"
 #include "TTFont.hpp"
 #include "TextField.hpp"
 #include "RenderTarget.hpp"
+#include "RenderThread.hpp"
+#include "Input.hpp"
+#include "Memory.hpp"
 #include "physics/Physics.hpp"
+#include "physics/DebugDraw.hpp"
 
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include <mruby.h>
 #include <mruby/value.h>
 #include <mruby/hash.h>
+#include <mruby/array.h>
 
 using namespace RubyAction;
 
-void mouseMoveEvent(sf::Event &event)
+// Dispatches the moves polled since the last mouse_move as one, to the last position. With Input.mouse_history
+// on, every position moved through is passed as well, packed as [x0, y0, x1, y1, ...].
+void flushMouseMove()
 {
+  static std::vector<int> moves;
+  if (!Input::takeMouseMoves(moves)) return;
+
   mrb_state *mrb = RubyEngine::getInstance()->getState();
+  const sf::Vector2i &position = Input::getMousePosition();
   mrb_value data[] = {
-    mrb_fixnum_value(event.mouseMove.x),
-    mrb_fixnum_value(event.mouseMove.y)
+    mrb_fixnum_value(position.x),
+    mrb_fixnum_value(position.y),
+    mrb_nil_value()
   };
-  Stage::getInstance()->dispatch(mrb_intern(mrb, "mouse_move"), data, 2);
+
+  if (!Input::mouseHistory)
+  {
+    Stage::getInstance()->dispatch(mrb_intern(mrb, "mouse_move"), data, 2);
+    return;
+  }
+
+  data[2] = mrb_ary_new_capa(mrb, moves.size());
+  for (size_t i = 0; i < moves.size(); i++)
+  {
+    mrb_ary_push(mrb, data[2], mrb_fixnum_value(moves[i]));
+  }
+  Stage::getInstance()->dispatch(mrb_intern(mrb, "mouse_move"), data, 3);
 }
 
 void mouseButtonEvent(sf::Event &event, const char *name)
@@ -50,35 +76,59 @@ void keyEvent(sf::Event &event, const char *name)
   Stage::getInstance()->dispatch(mrb_intern(mrb, name), &data, 1);
 }
 
-void processInputEvents(sf::RenderWindow &window)
+// Queues the window's pending events. The window handles a resize while it is polled by changing its view.
+void pollEvents(sf::RenderWindow &window, std::vector<sf::Event> &events)
 {
   sf::Event event;
   while (window.pollEvent(event))
   {
-    switch (event.type)
+    events.push_back(event);
+  }
+}
+
+// Updates the Input state table and dispatches the events queued. Mouse moves are coalesced, but flushed before
+// a button event so handlers still see where the button was pressed from. Returns the number of events handled.
+int processInputEvents(std::vector<sf::Event> &events)
+{
+  int count = events.size();
+  for (std::vector<sf::Event>::iterator event = events.begin(); event != events.end(); ++event)
+  {
+    switch (event->type)
     {
       case sf::Event::Closed:
-        window.close();
+        Application::getInstance()->close();
+        break;
+      case sf::Event::LostFocus:
+        Input::releaseAll();
         break;
       case sf::Event::MouseMoved:
-        mouseMoveEvent(event);
+        Input::moveMouse(event->mouseMove.x, event->mouseMove.y);
         break;
       case sf::Event::MouseButtonPressed:
-        mouseButtonEvent(event, "mouse_down");
+        flushMouseMove();
+        Input::setButton(event->mouseButton.button, true);
+        mouseButtonEvent(*event, "mouse_down");
         break;
       case sf::Event::MouseButtonReleased:
-        mouseButtonEvent(event, "mouse_up");
+        flushMouseMove();
+        Input::setButton(event->mouseButton.button, false);
+        mouseButtonEvent(*event, "mouse_up");
         break;
       case sf::Event::KeyPressed:
-        keyEvent(event, "key_down");
+        Input::setKey(event->key.code, true);
+        keyEvent(*event, "key_down");
         break;
       case sf::Event::KeyReleased:
-        keyEvent(event, "key_up");
+        Input::setKey(event->key.code, false);
+        keyEvent(*event, "key_up");
         break;
       default:
         break;
     }
   }
+  events.clear();
+  flushMouseMove();
+  return count;
 }
 
 Application *Application::instance = new Application();
@@ -91,14 +141,19 @@ Application* Application::getInstance()
 int Application::run(const char *filename)
 {
   window = new sf::RenderWindow(sf::VideoMode(config.width, config.height), config.title);
+  window->setVerticalSyncEnabled(config.vsync);
 
   RubyAction::RubyEngine *engine = RubyAction::RubyEngine::getInstance();
+  engine->bind(RubyAction::bindApplication);
+  engine->bind(RubyAction::bindInput);
+  engine->bind(RubyAction::bindMemory);
   engine->bind(RubyAction::bindEventDispatcher);
   engine->bind(RubyAction::bindTextureBase);
   engine->bind(RubyAction::bindTexture);
   engine->bind(RubyAction::bindSprite);
   engine->bind(RubyAction::bindBitmap);
   engine->bind(RubyAction::bindTextureRegion);
+  engine->bind(RubyAction::bindTileMap);
   engine->bind(RubyAction::bindStage);
   engine->bind(RubyAction::bindFontBase);
   engine->bind(RubyAction::bindFont);
@@ -110,26 +165,176 @@ int Application::run(const char *filename)
   if (!engine->load(filename)) return -1;
 
   sf::Clock clock;
+  std::vector<sf::Event> events;
+  if (config.renderThread) renderThread = new RenderThread(window, sf::Color::White);
+  nextFrame = lastActive = frameClock.getElapsedTime();
 
   while (window->isOpen())
   {
     int arena = mrb_gc_arena_save(engine->getState());
 
-    processInputEvents(*window);
+    if (!renderThread) pollEvents(*window, events);
+    bool active = processInputEvents(events) > 0;
+    if (!window->isOpen()) break;
 
-    mrb_value delta = mrb_float_value(engine->getState(), clock.restart().asSeconds());
+    sf::Time elapsed = clock.restart();
+    frameTimes.add(elapsed.asMicroseconds() / 1000.0f);
+    mrb_value delta = mrb_float_value(engine->getState(), elapsed.asSeconds());
     Stage::getInstance()->dispatch(mrb_intern(engine->getState(), "enter_frame"), &delta, 1);
 
-    window->clear(sf::Color::White);
-    Stage::getInstance()->render(window);
-    window->display();
+    if (renderThread)
+    {
+      // the window is only read for its view while the frame is recorded
+      renderThread->record();
+      Stage::getInstance()->render(window);
+      RubyAction::Physics::DebugDraw::renderAll(window);
+      // the view a resize sets while polling is the one the render thread draws with, so events are polled
+      // while it is idle and dispatched in the next frame
+      renderThread->wait();
+      pollEvents(*window, events);
+      renderThread->present();
+    }
+    else
+    {
+      window->clear(sf::Color::White);
+      Stage::getInstance()->render(window);
+      RubyAction::Physics::DebugDraw::renderAll(window);
+      window->display();
+    }
+    Sprite::resetRenderStats();
 
     mrb_gc_arena_restore(engine->getState(), arena);
 
     engine->garbageCollect();
+
+    waitForNextFrame(active || Sprite::changed);
+    Sprite::changed = false;
   }
 
-  window->close();
+  close();
   delete window;
   return 0;
 }
+
+// The render thread is stopped first, so the window's context is back on this thread when it is closed.
+void Application::close()
+{
+  delete renderThread;
+  renderThread = NULL;
+  window->close();
+}
+
+// Sleeps until the next frame is due at the target frame rate, or the idle one once nothing has changed for
+// idleDelay seconds. Sleeping stops SPIN_TIME short of the deadline, which the scheduler may overshoot, and
+// the rest is spun so frames start on time.
+void Application::waitForNextFrame(bool active)
+{
+  static const sf::Time SPIN_TIME = sf::milliseconds(2);
+
+  sf::Time now = frameClock.getElapsedTime();
+  if (active) lastActive = now;
+
+  int fps = config.targetFps;
+  if (config.idleFps > 0 && now - lastActive >= sf::seconds(config.idleDelay))
+    fps = fps > 0 ? std::min(fps, config.idleFps) : config.idleFps;
+
+  if (fps <= 0)
+  {
+    nextFrame = now;
+    return;
+  }
+
+  // frames are scheduled from the previous deadline so they don't drift, unless the previous one was missed
+  nextFrame = std::max(nextFrame + sf::microseconds(1000000 / fps), now);
+  if (nextFrame - now > SPIN_TIME) sf::sleep(nextFrame - now - SPIN_TIME);
+  while (frameClock.getElapsedTime() < nextFrame) {}
+}
+
+void Application::setVerticalSync(bool vsync)
+{
+  config.vsync = vsync;
+  if (renderThread)
+    renderThread->setVerticalSync(vsync);
+  else if (window)
+    window->setVerticalSyncEnabled(vsync);
+}
+
+mrb_value Application::getFrameTimes(mrb_state *mrb)
+{
+  return frameTimes.toHash(mrb);
+}
+
+static mrb_value Application_isVsync(mrb_state *mrb, mrb_value self)
+{
+  return mrb_bool_value(Application::getInstance()->config.vsync);
+}
+
+static mrb_value Application_setVsync(mrb_state *mrb, mrb_value self)
+{
+  mrb_bool vsync;
+  mrb_get_args(mrb, "b", &vsync);
+  Application::getInstance()->setVerticalSync(vsync);
+  return self;
+}
+
+static mrb_value Application_getTargetFps(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(Application::getInstance()->config.targetFps);
+}
+
+static mrb_value Application_setTargetFps(mrb_state *mrb, mrb_value self)
+{
+  mrb_int fps;
+  mrb_get_args(mrb, "i", &fps);
+  if (fps < 0) mrb_raise(mrb, E_ARGUMENT_ERROR, "frame rate must not be negative");
+  Application::getInstance()->config.targetFps = fps;
+  return self;
+}
+
+static mrb_value Application_getIdleFps(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(Application::getInstance()->config.idleFps);
+}
+
+static mrb_value Application_setIdleFps(mrb_state *mrb, mrb_value self)
+{
+  mrb_int fps;
+  mrb_get_args(mrb, "i", &fps);
+  if (fps < 0) mrb_raise(mrb, E_ARGUMENT_ERROR, "frame rate must not be negative");
+  Application::getInstance()->config.idleFps = fps;
+  return self;
+}
+
+static mrb_value Application_getIdleDelay(mrb_state *mrb, mrb_value self)
+{
+  return mrb_float_value(mrb, Application::getInstance()->config.idleDelay);
+}
+
+static mrb_value Application_setIdleDelay(mrb_state *mrb, mrb_value self)
+{
+  mrb_float delay;
+  mrb_get_args(mrb, "f", &delay);
+  if (delay < 0) mrb_raise(mrb, E_ARGUMENT_ERROR, "idle delay must not be negative");
+  Application::getInstance()->config.idleDelay = delay;
+  return self;
+}
+
+static mrb_value Application_getFrameTimes(mrb_state *mrb, mrb_value self)
+{
+  return Application::getInstance()->getFrameTimes(mrb);
+}
+
+void RubyAction::bindApplication(mrb_state *mrb, RClass *module)
+{
+  struct RClass *application = mrb_define_module_under(mrb, module, "Application");
+
+  mrb_define_module_function(mrb, application, "vsync?", Application_isVsync, MRB_ARGS_NONE());
+  mrb_define_module_function(mrb, application, "vsync=", Application_setVsync, MRB_ARGS_REQ(1));
+  mrb_define_module_function(mrb, application, "target_fps", Application_getTargetFps, MRB_ARGS_NONE());
+  mrb_define_module_function(mrb, application, "target_fps=", Application_setTargetFps, MRB_ARGS_REQ(1));
+  mrb_define_module_function(mrb, application, "idle_fps", Application_getIdleFps, MRB_ARGS_NONE());
+  mrb_define_module_function(mrb, application, "idle_fps=", Application_setIdleFps, MRB_ARGS_REQ(1));
+  mrb_define_module_function(mrb, application, "idle_delay", Application_getIdleDelay, MRB_ARGS_NONE());
+  mrb_define_module_function(mrb, application, "idle_delay=", Application_setIdleDelay, MRB_ARGS_REQ(1));
+  mrb_define_module_function(mrb, application, "frame_times", Application_getFrameTimes, MRB_ARGS_NONE());
+}
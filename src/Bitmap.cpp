@@ -5,23 +5,22 @@
 using namespace RubyAction;
 
 Bitmap::Bitmap(mrb_value self, mrb_value texture_region)
-  : Sprite(self)
+  : Sprite(self),
+    region(unwrap<TextureRegion>(texture_region))
 {
   setProperty("texture_region", texture_region);
-  TextureRegion *region = (TextureRegion*) getObject("texture_region");
   setWidth(region->getWidth());
   setHeight(region->getHeight());
 }
 
-void Bitmap::renderMe(sf::RenderTarget *renderer)
+bool Bitmap::renderMe(sf::RenderTarget *renderer, const sf::Transform &transform)
 {
-  sf::Transform transform = this->getTransform();
-  TextureRegion *region = (TextureRegion*) this->getObject("texture_region");
   TextureBase *texture = region->getTextureBase();
   sf::IntRect rect(region->getX(), region->getY(), region->getWidth(), region->getHeight());
   sf::Color color = this->getColor();
 
   texture->render(*renderer, transform, rect, color);
+  return true;
 }
 
 static mrb_value Bitmap_initialize(mrb_state *mrb, mrb_value self)
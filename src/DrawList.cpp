@@ -0,0 +1,122 @@
+#include "DrawList.hpp"
+#include <mruby/array.h>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace RubyAction;
+
+DrawList *DrawList::recording = NULL;
+
+// Returns the list the stage is being recorded into, or NULL when sprites are drawn directly.
+DrawList* DrawList::getRecording()
+{
+  return recording;
+}
+
+void DrawList::begin()
+{
+  vertices.clear();
+  commands.clear();
+  texts.clear();
+  owners.clear();
+  recording = this;
+}
+
+void DrawList::end()
+{
+  recording = NULL;
+}
+
+// Draws of independent primitives are merged into the previous command when they share its texture; strips
+// and fans can't be.
+DrawList::Command& DrawList::append(RubyObject *owner, const sf::Texture *texture, sf::PrimitiveType type)
+{
+  if (owner && (owners.empty() || owners.back() != owner)) owners.push_back(owner);
+
+  bool mergeable = type == sf::Quads || type == sf::Triangles || type == sf::Lines || type == sf::Points;
+  if (!commands.empty() && mergeable)
+  {
+    Command &last = commands.back();
+    if (last.text < 0 && last.texture == texture && last.type == type) return last;
+  }
+
+  Command command = { texture, type, vertices.size(), 0, -1 };
+  commands.push_back(command);
+  return commands.back();
+}
+
+// Records what an sf::Sprite showing rect of the texture would draw.
+void DrawList::addQuad(RubyObject *owner, const sf::Texture &texture, const sf::Transform &transform,
+  const sf::IntRect &rect, const sf::Color &color)
+{
+  Command &command = append(owner, &texture, sf::Quads);
+
+  float width = std::abs(rect.width);
+  float height = std::abs(rect.height);
+  float left = rect.left;
+  float right = left + rect.width;
+  float top = rect.top;
+  float bottom = top + rect.height;
+
+  vertices.push_back(sf::Vertex(transform.transformPoint(0, 0), color, sf::Vector2f(left, top)));
+  vertices.push_back(sf::Vertex(transform.transformPoint(width, 0), color, sf::Vector2f(right, top)));
+  vertices.push_back(sf::Vertex(transform.transformPoint(width, height), color, sf::Vector2f(right, bottom)));
+  vertices.push_back(sf::Vertex(transform.transformPoint(0, height), color, sf::Vector2f(left, bottom)));
+  command.count += 4;
+}
+
+void DrawList::addVertices(RubyObject *owner, const sf::Texture *texture, const sf::Transform &transform,
+  const sf::VertexArray &array)
+{
+  Command &command = append(owner, texture, array.getPrimitiveType());
+
+  size_t count = array.getVertexCount();
+  for (size_t i = 0; i < count; i++)
+  {
+    sf::Vertex vertex = array[i];
+    vertex.position = transform.transformPoint(vertex.position);
+    vertices.push_back(vertex);
+  }
+  command.count += count;
+}
+
+// Texts keep their own vertices, so they are copied as they are, their glyphs already loaded.
+void DrawList::addText(RubyObject *owner, const sf::Text &text, const sf::Transform &transform)
+{
+  if (owner && (owners.empty() || owners.back() != owner)) owners.push_back(owner);
+
+  texts.push_back(std::make_pair(text, transform));
+  Command command = { NULL, sf::Quads, 0, 0, int(texts.size() - 1) };
+  commands.push_back(command);
+}
+
+mrb_value DrawList::getOwners(mrb_state *mrb)
+{
+  mrb_value array = mrb_ary_new_capa(mrb, owners.size());
+  for (size_t i = 0; i < owners.size(); i++)
+  {
+    mrb_ary_push(mrb, array, owners[i]->getSelf());
+  }
+  return array;
+}
+
+// Whether the list draws the texture or font of owner.
+bool DrawList::draws(RubyObject *owner) const
+{
+  return std::find(owners.begin(), owners.end(), owner) != owners.end();
+}
+
+void DrawList::submit(sf::RenderTarget &target)
+{
+  for (std::vector<Command>::iterator command = commands.begin(); command != commands.end(); ++command)
+  {
+    if (command->text >= 0)
+    {
+      target.draw(texts[command->text].first, texts[command->text].second);
+    }
+    else if (command->count > 0)
+    {
+      target.draw(&vertices[command->first], command->count, command->type, sf::RenderStates(command->texture));
+    }
+  }
+}
@@ -25,6 +25,11 @@ void EventDispatcher::off()
   setProperty("listeners", mrb_hash_new(mrb));
 }
 
+bool EventDispatcher::hasListener(mrb_sym name)
+{
+  return !mrb_nil_p(mrb_hash_get(mrb, getProperty("listeners"), mrb_symbol_value(name)));
+}
+
 void EventDispatcher::dispatch(mrb_sym name, mrb_value* argv, int argc)
 {
   mrb_value listener = mrb_hash_get(mrb, getProperty("listeners"), mrb_symbol_value(name));
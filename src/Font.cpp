@@ -1,4 +1,5 @@
 #include "Font.hpp"
+#include "DrawList.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -76,6 +77,7 @@ void Font::render(sf::RenderTarget& target, const sf::Transform& transform, cons
   const sf::Color& color, const char *text)
 {
   sf::IntRect textBounds = getTextBounds(text);
+  DrawList *list = DrawList::getRecording();
 
   sf::Transform glyphTransform;
   glyphTransform.translate(-textBounds.left, -textBounds.top);
@@ -84,11 +86,19 @@ void Font::render(sf::RenderTarget& target, const sf::Transform& transform, cons
   for (int i = 0; i < strlen(text); ++i)
   {
     TextureGlyph glyph = fontInfo.glyphs[text[i]];
-    sprite.setColor(color);
-    sprite.setTextureRect(sf::IntRect(glyph.x, glyph.y, glyph.width, glyph.height));
+    sf::IntRect rect(glyph.x, glyph.y, glyph.width, glyph.height);
 
     glyphTransform.translate(glyph.left, glyph.top);
-    target.draw(sprite, transform * glyphTransform);
+    if (list)
+    {
+      list->addQuad(this, texture, transform * glyphTransform, rect, color);
+    }
+    else
+    {
+      sprite.setColor(color);
+      sprite.setTextureRect(rect);
+      target.draw(sprite, transform * glyphTransform);
+    }
     glyphTransform.translate(glyph.advancex - glyph.left, -glyph.top);
   }
 }
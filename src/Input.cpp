@@ -0,0 +1,104 @@
+#include "Input.hpp"
+#include <mruby/array.h>
+#include <algorithm>
+
+using namespace RubyAction;
+
+bool Input::keys[sf::Keyboard::KeyCount];
+bool Input::buttons[sf::Mouse::ButtonCount];
+sf::Vector2i Input::mousePosition;
+std::vector<int> Input::mouseMoves;
+bool Input::mouseHistory = false;
+
+void Input::setKey(int code, bool down)
+{
+  if (code >= 0 && code < sf::Keyboard::KeyCount) keys[code] = down;
+}
+
+bool Input::isKeyDown(int code)
+{
+  return code >= 0 && code < sf::Keyboard::KeyCount && keys[code];
+}
+
+void Input::setButton(int button, bool down)
+{
+  if (button >= 0 && button < sf::Mouse::ButtonCount) buttons[button] = down;
+}
+
+bool Input::isButtonDown(int button)
+{
+  return button >= 0 && button < sf::Mouse::ButtonCount && buttons[button];
+}
+
+void Input::moveMouse(int x, int y)
+{
+  mousePosition = sf::Vector2i(x, y);
+  mouseMoves.push_back(x);
+  mouseMoves.push_back(y);
+}
+
+const sf::Vector2i& Input::getMousePosition()
+{
+  return mousePosition;
+}
+
+// Hands the packed [x0, y0, x1, y1, ...] positions the mouse moved through since the last call over to moves,
+// and returns whether it moved at all.
+bool Input::takeMouseMoves(std::vector<int> &moves)
+{
+  moves.swap(mouseMoves);
+  mouseMoves.clear();
+  return !moves.empty();
+}
+
+// Keys and buttons released while the window is not focused are never reported.
+void Input::releaseAll()
+{
+  std::fill(keys, keys + sf::Keyboard::KeyCount, false);
+  std::fill(buttons, buttons + sf::Mouse::ButtonCount, false);
+}
+
+static mrb_value Input_isKeyDown(mrb_state *mrb, mrb_value self)
+{
+  mrb_int code;
+  mrb_get_args(mrb, "i", &code);
+  return mrb_bool_value(Input::isKeyDown(code));
+}
+
+static mrb_value Input_isMouseDown(mrb_state *mrb, mrb_value self)
+{
+  mrb_int button;
+  mrb_get_args(mrb, "i", &button);
+  return mrb_bool_value(Input::isButtonDown(button));
+}
+
+static mrb_value Input_getMousePosition(mrb_state *mrb, mrb_value self)
+{
+  const sf::Vector2i &position = Input::getMousePosition();
+  mrb_value values[2] = { mrb_fixnum_value(position.x), mrb_fixnum_value(position.y) };
+  return mrb_ary_new_from_values(mrb, 2, values);
+}
+
+static mrb_value Input_isMouseHistory(mrb_state *mrb, mrb_value self)
+{
+  return mrb_bool_value(Input::mouseHistory);
+}
+
+static mrb_value Input_setMouseHistory(mrb_state *mrb, mrb_value self)
+{
+  mrb_bool history;
+  mrb_get_args(mrb, "b", &history);
+  Input::mouseHistory = history;
+  return self;
+}
+
+void RubyAction::bindInput(mrb_state *mrb, RClass *module)
+{
+  struct RClass *input = mrb_define_module_under(mrb, module, "Input");
+
+  mrb_define_module_function(mrb, input, "key_down?", Input_isKeyDown, MRB_ARGS_REQ(1));
+  mrb_define_module_function(mrb, input, "mouse_down?", Input_isMouseDown, MRB_ARGS_REQ(1));
+  mrb_define_module_function(mrb, input, "mouse_position", Input_getMousePosition, MRB_ARGS_NONE());
+  mrb_define_module_function(mrb, input, "mouse_history?", Input_isMouseHistory, MRB_ARGS_NONE());
+  mrb_define_module_function(mrb, input, "mouse_history=", Input_setMouseHistory, MRB_ARGS_REQ(1));
+}
@@ -0,0 +1,254 @@
+#include "Memory.hpp"
+#include "util/hash.hpp"
+#include <mruby/array.h>
+#include <mruby/hash.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace RubyAction;
+
+// Every block starts with the size asked for, since mruby doesn't pass it back when freeing.
+static const size_t HEADER = sizeof(size_t);
+static const size_t SMALLEST = 16;
+static const size_t CHUNK_SIZE = 64 * 1024;
+
+Memory::Memory()
+  : bytes(0),
+    peak(0),
+    limit(0),
+    failures(0)
+{
+  std::fill(freeLists, freeLists + CLASSES, (Block*) NULL);
+  Stats empty = { 0, 0, 0 };
+  std::fill(classes, classes + CLASSES + 1, empty);
+}
+
+Memory::~Memory()
+{
+  for (size_t i = 0; i < chunks.size(); i++) free(chunks[i]);
+}
+
+// Returns the size class of a block of the given size, header included, or -1 when it is too large for one.
+int Memory::classOf(size_t size)
+{
+  int index = 0;
+  for (size_t blockSize = SMALLEST; blockSize < size; blockSize *= 2)
+  {
+    if (++index == CLASSES) return -1;
+  }
+  return index;
+}
+
+// Accounts for size more bytes, unless they would exceed the limit. mruby then collects garbage and asks again.
+bool Memory::reserve(size_t size)
+{
+  if (limit && bytes + size > limit)
+  {
+    failures++;
+    return false;
+  }
+
+  bytes += size;
+  peak = std::max(peak, bytes);
+  return true;
+}
+
+void* Memory::allocate(size_t size)
+{
+  if (!reserve(size)) return NULL;
+
+  int index = classOf(size + HEADER);
+  Stats &stats = classes[index < 0 ? CLASSES : index];
+  char *block;
+
+  if (index < 0)
+  {
+    block = (char*) malloc(size + HEADER);
+  }
+  else
+  {
+    if (!freeLists[index])
+    {
+      size_t blockSize = SMALLEST << index;
+      char *chunk = (char*) malloc(CHUNK_SIZE);
+      if (chunk)
+      {
+        chunks.push_back(chunk);
+        for (size_t offset = CHUNK_SIZE; offset >= blockSize; )
+        {
+          offset -= blockSize;
+          Block *unused = (Block*) (chunk + offset);
+          unused->next = freeLists[index];
+          freeLists[index] = unused;
+        }
+      }
+    }
+
+    block = (char*) freeLists[index];
+    if (block) freeLists[index] = freeLists[index]->next;
+  }
+
+  if (!block)
+  {
+    bytes -= size;
+    failures++;
+    return NULL;
+  }
+
+  *(size_t*) block = size;
+  stats.blocks++;
+  stats.bytes += size;
+  stats.allocations++;
+  return block + HEADER;
+}
+
+// Blocks that stay in their size class are resized in place; large ones are left to realloc.
+void* Memory::reallocate(void *pointer, size_t size)
+{
+  char *block = (char*) pointer - HEADER;
+  size_t old = *(size_t*) block;
+  int from = classOf(old + HEADER);
+  int to = classOf(size + HEADER);
+
+  if (from != to || from < 0)
+  {
+    if (from >= 0 || to >= 0)
+    {
+      void *moved = allocate(size);
+      if (!moved) return NULL;
+      memcpy(moved, pointer, std::min(old, size));
+      release(pointer);
+      return moved;
+    }
+
+    if (size > old && !reserve(size - old)) return NULL;
+    char *resized = (char*) realloc(block, size + HEADER);
+    if (!resized)
+    {
+      if (size > old) bytes -= size - old;
+      failures++;
+      return NULL;
+    }
+    block = resized;
+  }
+  else if (size > old && !reserve(size - old))
+  {
+    return NULL;
+  }
+
+  if (size < old) bytes -= old - size;
+  Stats &stats = classes[to < 0 ? CLASSES : to];
+  stats.bytes = stats.bytes - old + size;
+  *(size_t*) block = size;
+  return block + HEADER;
+}
+
+void Memory::release(void *pointer)
+{
+  char *block = (char*) pointer - HEADER;
+  size_t size = *(size_t*) block;
+  int index = classOf(size + HEADER);
+
+  Stats &stats = classes[index < 0 ? CLASSES : index];
+  stats.blocks--;
+  stats.bytes -= size;
+  bytes -= size;
+
+  if (index < 0)
+  {
+    free(block);
+  }
+  else
+  {
+    Block *unused = (Block*) block;
+    unused->next = freeLists[index];
+    freeLists[index] = unused;
+  }
+}
+
+// The mrb_allocf of states opened with a Memory as their user data: frees when size is 0, and allocates or
+// resizes otherwise.
+void* Memory::allocf(mrb_state *mrb, void *pointer, size_t size, void *ud)
+{
+  Memory *memory = (Memory*) ud;
+  if (size == 0)
+  {
+    if (pointer) memory->release(pointer);
+    return NULL;
+  }
+  return pointer ? memory->reallocate(pointer, size) : memory->allocate(size);
+}
+
+size_t Memory::getLimit()
+{
+  return limit;
+}
+
+void Memory::setLimit(size_t limit)
+{
+  this->limit = limit;
+}
+
+// Returns { bytes:, peak:, limit:, chunk_bytes:, failures:, classes: [{ size:, blocks:, bytes:,
+// allocations: }, ...] }, the last class holding the blocks too large for one, with a nil size.
+mrb_value Memory::getStats(mrb_state *mrb)
+{
+  // building the hash allocates, so it reports the counts as they were when asked
+  Stats counts[CLASSES + 1];
+  std::copy(classes, classes + CLASSES + 1, counts);
+  size_t totals[] = { bytes, peak, limit, chunks.size() * CHUNK_SIZE, failures };
+
+  mrb_value hash = mrb_hash_new(mrb);
+  H_SET_VALUE(hash, "bytes", mrb_fixnum_value(totals[0]));
+  H_SET_VALUE(hash, "peak", mrb_fixnum_value(totals[1]));
+  H_SET_VALUE(hash, "limit", mrb_fixnum_value(totals[2]));
+  H_SET_VALUE(hash, "chunk_bytes", mrb_fixnum_value(totals[3]));
+  H_SET_VALUE(hash, "failures", mrb_fixnum_value(totals[4]));
+
+  mrb_value list = mrb_ary_new_capa(mrb, CLASSES + 1);
+  for (int i = 0; i <= CLASSES; i++)
+  {
+    mrb_value stats = mrb_hash_new(mrb);
+    H_SET_VALUE(stats, "size", i < CLASSES ? mrb_fixnum_value((SMALLEST << i) - HEADER) : mrb_nil_value());
+    H_SET_VALUE(stats, "blocks", mrb_fixnum_value(counts[i].blocks));
+    H_SET_VALUE(stats, "bytes", mrb_fixnum_value(counts[i].bytes));
+    H_SET_VALUE(stats, "allocations", mrb_fixnum_value(counts[i].allocations));
+    mrb_ary_push(mrb, list, stats);
+  }
+  H_SET_VALUE(hash, "classes", list);
+  return hash;
+}
+
+static Memory* getMemory(mrb_state *mrb)
+{
+  return (Memory*) mrb->ud;
+}
+
+static mrb_value Memory_getStats(mrb_state *mrb, mrb_value self)
+{
+  return getMemory(mrb)->getStats(mrb);
+}
+
+static mrb_value Memory_getLimit(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(getMemory(mrb)->getLimit());
+}
+
+static mrb_value Memory_setLimit(mrb_state *mrb, mrb_value self)
+{
+  mrb_int limit;
+  mrb_get_args(mrb, "i", &limit);
+  if (limit < 0) mrb_raise(mrb, E_ARGUMENT_ERROR, "limit must not be negative");
+  getMemory(mrb)->setLimit(limit);
+  return self;
+}
+
+void RubyAction::bindMemory(mrb_state *mrb, RClass *module)
+{
+  struct RClass *memory = mrb_define_module_under(mrb, module, "Memory");
+
+  mrb_define_module_function(mrb, memory, "stats", Memory_getStats, MRB_ARGS_NONE());
+  mrb_define_module_function(mrb, memory, "limit", Memory_getLimit, MRB_ARGS_NONE());
+  mrb_define_module_function(mrb, memory, "limit=", Memory_setLimit, MRB_ARGS_REQ(1));
+}
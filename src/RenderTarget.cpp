@@ -1,32 +1,99 @@
 #include "RenderTarget.hpp"
+#include "RenderThread.hpp"
+#include <mruby/array.h>
 
 using namespace RubyAction;
 
 RenderTarget::RenderTarget(mrb_value self, float width, float height)
-  : TextureBase(self)
+  : TextureBase(self),
+    batching(false),
+    lazy(false),
+    dirty(false)
 {
   this->width = width;
   this->height = height;
   texture.create(width, height);
   texture.clear(sf::Color::Transparent);
+  texture.display();
+  sprite.setTexture(texture.getTexture());
+}
+
+void RenderTarget::begin()
+{
+  batching = true;
+}
+
+void RenderTarget::end()
+{
+  batching = false;
+  flush();
+}
+
+bool RenderTarget::isBatching()
+{
+  return batching;
 }
 
 void RenderTarget::draw(Sprite* sprite)
 {
+  RenderThread::sync(this);
   sprite->render(&texture);
-  texture.display();
+  dirty = true;
+  Sprite::changed = true;
+  flush();
 }
 
 void RenderTarget::clear()
 {
+  RenderThread::sync(this);
   texture.clear(sf::Color::Transparent);
+  dirty = true;
+  Sprite::changed = true;
+  flush();
+}
+
+bool RenderTarget::isLazy()
+{
+  return lazy;
+}
+
+void RenderTarget::setLazy(bool lazy)
+{
+  this->lazy = lazy;
+  flush();
+}
+
+// Flushes pending draws unless they are being batched or deferred until the target is sampled.
+void RenderTarget::flush()
+{
+  if (!batching && !lazy) resolve();
+}
+
+void RenderTarget::resolve()
+{
+  if (!dirty) return;
+  RenderThread::sync(this);
   texture.display();
+  dirty = false;
+}
+
+const sf::Texture& RenderTarget::getTexture()
+{
+  resolve();
+  return texture.getTexture();
 }
 
 void RenderTarget::render(sf::RenderTarget &target, const sf::Transform &transform, const sf::IntRect &rect,
   const sf::Color &color)
 {
-  sprite.setTexture(texture.getTexture());
+  resolve();
+  DrawList *list = DrawList::getRecording();
+  if (list)
+  {
+    list->addQuad(this, texture.getTexture(), transform, rect, color);
+    return;
+  }
+
   sprite.setColor(color);
   sprite.setTextureRect(rect);
   target.draw(sprite, transform);
@@ -41,6 +108,18 @@ static mrb_value RenderTarget_initialize(mrb_state *mrb, mrb_value self)
   return self;
 }
 
+static mrb_value RenderTarget_begin(mrb_state *mrb, mrb_value self)
+{
+  unwrap<RenderTarget>(self)->begin();
+  return self;
+}
+
+static mrb_value RenderTarget_end(mrb_state *mrb, mrb_value self)
+{
+  unwrap<RenderTarget>(self)->end();
+  return self;
+}
+
 static mrb_value RenderTarget_draw(mrb_state *mrb, mrb_value self)
 {
   mrb_value s;
@@ -57,12 +136,52 @@ static mrb_value RenderTarget_draw(mrb_state *mrb, mrb_value self)
   return self;
 }
 
+static mrb_value RenderTarget_drawAll(mrb_state *mrb, mrb_value self)
+{
+  mrb_value sprites;
+  mrb_get_args(mrb, "A", &sprites);
+
+  struct RClass *module = mrb_class_get(mrb, "RubyAction");
+  struct RClass *clazz = mrb_class_get_under(mrb, module, "Sprite");
+  for (int i = 0; i < RARRAY_LEN(sprites); i++)
+  {
+    if (!mrb_obj_is_kind_of(mrb, mrb_ary_ref(mrb, sprites, i), clazz))
+    {
+      mrb_raise(mrb, E_TYPE_ERROR, "expected Sprite");
+    }
+  }
+
+  // inside a begin/end block of the script's, the draws are left for its end to flush
+  RenderTarget *target = unwrap<RenderTarget>(self);
+  bool batching = target->isBatching();
+  if (!batching) target->begin();
+  for (int i = 0; i < RARRAY_LEN(sprites); i++)
+  {
+    target->draw(unwrap<Sprite>(mrb_ary_ref(mrb, sprites, i)));
+  }
+  if (!batching) target->end();
+  return self;
+}
+
 static mrb_value RenderTarget_clear(mrb_state *mrb, mrb_value self)
 {
   unwrap<RenderTarget>(self)->clear();
   return self;
 }
 
+static mrb_value RenderTarget_isLazy(mrb_state *mrb, mrb_value self)
+{
+  return mrb_bool_value(unwrap<RenderTarget>(self)->isLazy());
+}
+
+static mrb_value RenderTarget_setLazy(mrb_state *mrb, mrb_value self)
+{
+  mrb_bool lazy;
+  mrb_get_args(mrb, "b", &lazy);
+  unwrap<RenderTarget>(self)->setLazy(lazy);
+  return self;
+}
+
 void RubyAction::bindRenderTarget(mrb_state *mrb, RClass *module)
 {
   struct RClass *super = mrb_class_get_under(mrb, module, "TextureBase");
@@ -70,6 +189,11 @@ void RubyAction::bindRenderTarget(mrb_state *mrb, RClass *module)
   MRB_SET_INSTANCE_TT(clazz, MRB_TT_DATA);
 
   mrb_define_method(mrb, clazz, "initialize", RenderTarget_initialize, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "begin", RenderTarget_begin, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "end", RenderTarget_end, MRB_ARGS_NONE());
   mrb_define_method(mrb, clazz, "draw", RenderTarget_draw, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "draw_all", RenderTarget_drawAll, MRB_ARGS_REQ(1));
   mrb_define_method(mrb, clazz, "clear", RenderTarget_clear, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "lazy?", RenderTarget_isLazy, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "lazy=", RenderTarget_setLazy, MRB_ARGS_REQ(1));
 }
@@ -0,0 +1,109 @@
+#include "RenderThread.hpp"
+#include "Stage.hpp"
+
+using namespace RubyAction;
+
+RenderThread *RenderThread::instance = NULL;
+
+// The window's context is handed over to the render thread; the main thread keeps polling its events and
+// loading textures, which SFML does in a context of its own.
+RenderThread::RenderThread(sf::RenderWindow *window, const sf::Color &clearColor)
+  : window(window),
+    clearColor(clearColor),
+    submitting(NULL),
+    back(0),
+    vsync(-1),
+    stopping(false)
+{
+  instance = this;
+  window->setActive(false);
+  thread = std::thread(&RenderThread::run, this);
+}
+
+RenderThread::~RenderThread()
+{
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    wake.notify_one();
+  }
+  thread.join();
+  instance = NULL;
+  window->setActive(true);
+}
+
+void RenderThread::run()
+{
+  window->setActive(true);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    wake.wait(lock, [this] { return submitting || stopping; });
+    if (stopping) break;
+
+    int pendingVsync = vsync;
+    vsync = -1;
+    lock.unlock();
+    if (pendingVsync >= 0) window->setVerticalSyncEnabled(pendingVsync);
+    window->clear(clearColor);
+    submitting->submit(*window);
+    window->display();
+    lock.lock();
+    submitting = NULL;
+    done.notify_all();
+  }
+
+  window->setActive(false);
+}
+
+// Starts recording the next frame into the back list, while the front one may still be submitted.
+DrawList* RenderThread::record()
+{
+  lists[back].begin();
+  return &lists[back];
+}
+
+// Waits for the previous frame to be displayed, then hands the recorded list over to the render thread. The
+// textures and fonts it draws are kept alive by the stage until it has been submitted.
+void RenderThread::present()
+{
+  DrawList *list = &lists[back];
+  list->end();
+  wait();
+
+  mrb_state *mrb = RubyEngine::getInstance()->getState();
+  Stage::getInstance()->setProperty("drawing", list->getOwners(mrb));
+
+  std::lock_guard<std::mutex> lock(mutex);
+  submitting = list;
+  back = 1 - back;
+  wake.notify_one();
+}
+
+// The window's context belongs to the render thread, which changes the swap interval before its next frame.
+void RenderThread::setVerticalSync(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  vsync = enabled;
+}
+
+void RenderThread::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this] { return !submitting; });
+}
+
+void RenderThread::wait(RubyObject *owner)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this, owner] { return !submitting || !submitting->draws(owner); });
+}
+
+// Waits for the frame being submitted, if it draws the texture or font of owner, before the main thread changes
+// that texture or font.
+void RenderThread::sync(RubyObject *owner)
+{
+  if (instance) instance->wait(owner);
+}
@@ -13,7 +13,7 @@ RubyEngine* RubyEngine::getInstance()
 
 RubyEngine::RubyEngine()
 {
-  mrb = mrb_open();
+  mrb = mrb_open_allocf(Memory::allocf, &memory);
   module = mrb_define_module(mrb, "RubyAction");
 }
 
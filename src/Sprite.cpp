@@ -3,9 +3,14 @@
 #include <mruby/array.h>
 #include <mruby/class.h>
 #include <mruby/variable.h>
+#include <algorithm>
 
 using namespace RubyAction;
 
+Sprite::RenderStats Sprite::renderStats = { 0, 0 };
+Sprite::RenderStats Sprite::lastRenderStats = { 0, 0 };
+bool Sprite::changed = true;
+
 Sprite::Sprite(mrb_value self)
   : EventDispatcher(self),
     x(0),
@@ -18,7 +23,11 @@ Sprite::Sprite(mrb_value self)
     anchorY(0),
     rotation(0),
     visible(true),
-    color(sf::Color::White)
+    color(sf::Color::White),
+    cullChildren(false),
+    boundsDirty(true),
+    transformDirty(true),
+    worldSubtreeDirty(true)
 {
   if (!mrb_nil_p(self))
   {
@@ -33,7 +42,9 @@ float Sprite::getX()
 
 void Sprite::setX(float x)
 {
+  if (this->x == x) return;
   this->x = x;
+  invalidateTransform();
 }
 
 float Sprite::getY()
@@ -43,7 +54,9 @@ float Sprite::getY()
 
 void Sprite::setY(float y)
 {
+  if (this->y == y) return;
   this->y = y;
+  invalidateTransform();
 }
 
 int Sprite::getWidth()
@@ -53,7 +66,9 @@ int Sprite::getWidth()
 
 void Sprite::setWidth(int width)
 {
+  if (this->width == width) return;
   this->width = width;
+  invalidateTransform();
 }
 
 int Sprite::getHeight()
@@ -63,7 +78,9 @@ int Sprite::getHeight()
 
 void Sprite::setHeight(int height)
 {
+  if (this->height == height) return;
   this->height = height;
+  invalidateTransform();
 }
 
 float Sprite::getScaleX()
@@ -73,7 +90,9 @@ float Sprite::getScaleX()
 
 void Sprite::setScaleX(float scaleX)
 {
+  if (this->scaleX == scaleX) return;
   this->scaleX = scaleX;
+  invalidateTransform();
 }
 
 float Sprite::getScaleY()
@@ -83,7 +102,9 @@ float Sprite::getScaleY()
 
 void Sprite::setScaleY(float scaleY)
 {
+  if (this->scaleY == scaleY) return;
   this->scaleY = scaleY;
+  invalidateTransform();
 }
 
 float Sprite::getAnchorX()
@@ -93,7 +114,9 @@ float Sprite::getAnchorX()
 
 void Sprite::setAnchorX(float anchorX)
 {
+  if (this->anchorX == anchorX) return;
   this->anchorX = anchorX;
+  invalidateTransform();
 }
 
 float Sprite::getAnchorY()
@@ -103,7 +126,9 @@ float Sprite::getAnchorY()
 
 void Sprite::setAnchorY(float anchorY)
 {
+  if (this->anchorY == anchorY) return;
   this->anchorY = anchorY;
+  invalidateTransform();
 }
 
 float Sprite::getRotation()
@@ -113,7 +138,9 @@ float Sprite::getRotation()
 
 void Sprite::setRotation(float rotation)
 {
+  if (this->rotation == rotation) return;
   this->rotation = rotation;
+  invalidateTransform();
 }
 
 bool Sprite::isVisible()
@@ -123,7 +150,9 @@ bool Sprite::isVisible()
 
 void Sprite::setVisible(bool visible)
 {
+  if (this->visible == visible) return;
   this->visible = visible;
+  changed = true;
 }
 
 Sprite* Sprite::getParent()
@@ -131,14 +160,27 @@ Sprite* Sprite::getParent()
   return mrb_nil_p(getProperty("parent")) ? NULL : (Sprite*) getObject("parent");
 }
 
+bool Sprite::isCullingChildren()
+{
+  return cullChildren;
+}
+
+void Sprite::setCullChildren(bool cullChildren)
+{
+  this->cullChildren = cullChildren;
+}
+
 void Sprite::setParent(Sprite *parent)
 {
   setProperty("parent", parent ? parent->getSelf() : mrb_nil_value());
+  invalidateWorldTransform();
 }
 
 void Sprite::setColor(sf::Color color)
 {
+  if (this->color == color) return;
   this->color = color;
+  changed = true;
 }
 
 const sf::Color& Sprite::getColor()
@@ -146,11 +188,52 @@ const sf::Color& Sprite::getColor()
   return color;
 }
 
+sf::FloatRect Sprite::getViewport(sf::RenderTarget *renderer)
+{
+  const sf::View &view = renderer->getView();
+  const sf::Vector2f &center = view.getCenter();
+  const sf::Vector2f &size = view.getSize();
+  return sf::FloatRect(center.x - size.x / 2, center.y - size.y / 2, size.x, size.y);
+}
+
+void Sprite::resetRenderStats()
+{
+  lastRenderStats = renderStats;
+  renderStats.drawn = 0;
+  renderStats.culled = 0;
+}
+
 void Sprite::render(sf::RenderTarget *renderer)
 {
   if (!isVisible()) return;
 
-  this->renderMe(renderer);
+  const sf::Transform &transform = this->getTransform();
+  sf::FloatRect viewport = getViewport(renderer);
+
+  if (cullChildren)
+  {
+    if (worldSubtreeDirty)
+    {
+      worldSubtreeBounds = transform.transformRect(getSubtreeBounds());
+      worldSubtreeDirty = false;
+    }
+    if (!worldSubtreeBounds.intersects(viewport))
+    {
+      renderStats.culled++;
+      return;
+    }
+  }
+
+  // sprites without a size (e.g. containers or unsized text) can't be tested and are always drawn
+  sf::FloatRect content = getContentBounds();
+  if (content.width > 0 && content.height > 0 && !worldBounds.intersects(viewport))
+  {
+    renderStats.culled++;
+  }
+  else if (this->renderMe(renderer, transform))
+  {
+    renderStats.drawn++;
+  }
 
   mrb_value children = getProperty("children");
   for (int i = 0; i < RARRAY_LEN(children); i++)
@@ -168,6 +251,7 @@ void Sprite::addChild(mrb_value child)
     Sprite* childSprite = unwrap<Sprite>(child);
     childSprite->removeFromParent();
     childSprite->setParent(this);
+    invalidateBounds();
   }
 }
 
@@ -186,6 +270,7 @@ void Sprite::removeChild(mrb_value child)
 
     setProperty("children", children);
     unwrap<Sprite>(child)->setParent(NULL);
+    invalidateBounds();
   }
 }
 
@@ -250,7 +335,68 @@ void Sprite::dispatch(mrb_sym name, mrb_value* argv, int argc)
   EventDispatcher::dispatch(name, argv, argc);
 }
 
-const sf::Transform& Sprite::getTransform()
+sf::FloatRect Sprite::getContentBounds()
+{
+  return sf::FloatRect(0, 0, width, height);
+}
+
+// Bounds of this sprite and all its descendants in local coordinates; cached until
+// a transform or size below this sprite changes.
+const sf::FloatRect& Sprite::getSubtreeBounds()
+{
+  if (!boundsDirty) return subtreeBounds;
+
+  float left = 0, top = 0, right = width, bottom = height;
+
+  mrb_value children = getProperty("children");
+  for (int i = 0; i < RARRAY_LEN(children); i++)
+  {
+    Sprite *child = unwrap<Sprite>(mrb_ary_ref(mrb, children, i));
+    sf::FloatRect bounds = child->getLocalTransform().transformRect(child->getSubtreeBounds());
+    left = std::min(left, bounds.left);
+    top = std::min(top, bounds.top);
+    right = std::max(right, bounds.left + bounds.width);
+    bottom = std::max(bottom, bounds.top + bounds.height);
+  }
+
+  subtreeBounds = sf::FloatRect(left, top, right - left, bottom - top);
+  boundsDirty = false;
+  return subtreeBounds;
+}
+
+// A dirty sprite always has dirty ancestors, so the walk stops at the first one already marked.
+void Sprite::invalidateBounds()
+{
+  changed = true;
+  for (Sprite *sprite = this; sprite && !sprite->boundsDirty; sprite = sprite->getParent())
+  {
+    sprite->boundsDirty = true;
+    sprite->worldSubtreeDirty = true;
+  }
+}
+
+void Sprite::invalidateTransform()
+{
+  invalidateBounds();
+  invalidateWorldTransform();
+}
+
+// The world transform depends on every ancestor's, so it is invalidated down the subtree. A transform is only
+// computed after its parent's, so a dirty sprite always has dirty descendants and the walk stops there.
+void Sprite::invalidateWorldTransform()
+{
+  if (transformDirty) return;
+  transformDirty = true;
+  worldSubtreeDirty = true;
+
+  mrb_value children = getProperty("children");
+  for (int i = 0; i < RARRAY_LEN(children); i++)
+  {
+    unwrap<Sprite>(mrb_ary_ref(mrb, children, i))->invalidateWorldTransform();
+  }
+}
+
+sf::Transform Sprite::getLocalTransform()
 {
   sf::Transform anchor;
   anchor.translate(-width * scaleX * anchorX, -height * scaleY * anchorY);
@@ -260,11 +406,21 @@ const sf::Transform& Sprite::getTransform()
   translate.translate(x, y);
   sf::Transform scale;
   scale.scale(scaleX, scaleY);
-  this->transform = translate * (rotate * anchor) * scale;
+  return translate * (rotate * anchor) * scale;
+}
+
+// The world transform and the world bounds of the sprite's content, cached until it or an ancestor moves.
+const sf::Transform& Sprite::getTransform()
+{
+  if (!transformDirty) return transform;
+
+  this->transform = getLocalTransform();
 
   Sprite *parent = this->getParent();
   if (parent) transform = parent->getTransform() * transform;
 
+  worldBounds = transform.transformRect(getContentBounds());
+  transformDirty = false;
   return transform;
 }
 
@@ -468,6 +624,28 @@ static mrb_value Sprite_setVisible(mrb_state *mrb, mrb_value self)
   return self;
 }
 
+static mrb_value Sprite_isCullingChildren(mrb_state *mrb, mrb_value self)
+{
+  return mrb_bool_value(unwrap<Sprite>(self)->isCullingChildren());
+}
+
+static mrb_value Sprite_setCullChildren(mrb_state *mrb, mrb_value self)
+{
+  mrb_bool cullChildren;
+  mrb_get_args(mrb, "b", &cullChildren);
+  unwrap<Sprite>(self)->setCullChildren(cullChildren);
+  return self;
+}
+
+static mrb_value Sprite_getRenderStats(mrb_state *mrb, mrb_value self)
+{
+  mrb_value stats[2] = {
+    mrb_fixnum_value(Sprite::lastRenderStats.drawn),
+    mrb_fixnum_value(Sprite::lastRenderStats.culled)
+  };
+  return mrb_ary_new_from_values(mrb, 2, stats);
+}
+
 static mrb_value Sprite_getParent(mrb_state *mrb, mrb_value self)
 {
   Sprite *parent = unwrap<Sprite>(self)->getParent();
@@ -645,6 +823,8 @@ void RubyAction::bindSprite(mrb_state *mrb, RClass *module)
   mrb_define_method(mrb, clazz, "rotation=", Sprite_setRotation, MRB_ARGS_REQ(1));
   mrb_define_method(mrb, clazz, "visible?", Sprite_isVisible, MRB_ARGS_NONE());
   mrb_define_method(mrb, clazz, "visible=", Sprite_setVisible, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "cull_children?", Sprite_isCullingChildren, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "cull_children=", Sprite_setCullChildren, MRB_ARGS_REQ(1));
   mrb_define_method(mrb, clazz, "parent", Sprite_getParent, MRB_ARGS_NONE());
   mrb_define_method(mrb, clazz, "color", Sprite_getColor, MRB_ARGS_NONE());
   mrb_define_method(mrb, clazz, "color=", Sprite_setColor, MRB_ARGS_REQ(1));
@@ -657,6 +837,8 @@ void RubyAction::bindSprite(mrb_state *mrb, RClass *module)
   mrb_define_method(mrb, clazz, "to_global", Sprite_localToGlobal, MRB_ARGS_REQ(2));
   mrb_define_method(mrb, clazz, "collide?", Sprite_collide, MRB_ARGS_REQ(2));
 
+  mrb_define_class_method(mrb, clazz, "render_stats", Sprite_getRenderStats, MRB_ARGS_NONE());
+
   // alias
   mrb_alias_method(mrb, clazz, mrb_intern(mrb, "<<"), mrb_intern(mrb, "add"));
   mrb_alias_method(mrb, clazz, mrb_intern(mrb, ">>"), mrb_intern(mrb, "remove"));
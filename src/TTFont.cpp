@@ -1,4 +1,5 @@
 #include "TTFont.hpp"
+#include "RenderThread.hpp"
 #include <sstream>
 #include <cstring>
 
@@ -16,10 +17,31 @@ TTFont::TTFont(mrb_value self, const char *filename, int size) : FontBase(self)
   text.setCharacterSize(size);
 }
 
+// Whether text has characters never laid out before, whose glyphs would be added to the font's texture.
+bool TTFont::addsGlyphs(const char *text)
+{
+  bool adds = false;
+  for (const unsigned char *c = (const unsigned char*) text; *c; c++)
+  {
+    if (!laidOut[*c])
+    {
+      laidOut[*c] = true;
+      adds = true;
+    }
+  }
+  return adds;
+}
+
 void TTFont::render(sf::RenderTarget& renderer, const sf::Transform& transform, const sf::IntRect& bounds,
   const sf::Color& color, const char *text)
 {
-  this->text.setString(text);
+  if (string != text)
+  {
+    // laying the text out may add glyphs to the font's texture, which the frame being submitted may draw
+    if (addsGlyphs(text)) RenderThread::sync(this);
+    string = text;
+    this->text.setString(text);
+  }
   this->text.setColor(color);
 
   sf::FloatRect localBounds = this->text.getLocalBounds();
@@ -27,7 +49,11 @@ void TTFont::render(sf::RenderTarget& renderer, const sf::Transform& transform,
   // localTransform.scale(bounds.width / localBounds.width, bounds.height / localBounds.height);
   localTransform.translate(-localBounds.left, -localBounds.top);
 
-  renderer.draw(this->text, transform * localTransform);
+  DrawList *list = DrawList::getRecording();
+  if (list)
+    list->addText(this, this->text, transform * localTransform);
+  else
+    renderer.draw(this->text, transform * localTransform);
 }
 
 static mrb_value TTFont_initialize(mrb_state *mrb, mrb_value self)
@@ -6,23 +6,26 @@ using namespace RubyAction;
 
 TextField::TextField(mrb_value self, mrb_value font, const char *text)
   : Sprite(self),
+    font(unwrap<FontBase>(font)),
     text(text)
 {
   setProperty("font", font);
 }
 
-void TextField::renderMe(sf::RenderTarget *renderer)
+bool TextField::renderMe(sf::RenderTarget *renderer, const sf::Transform &transform)
 {
-  sf::Transform transform = this->getTransform();
+  if (text.empty()) return false;
+
   sf::Color color = this->getColor();
   const sf::IntRect bounds(0, 0, getWidth(), getHeight());
-  FontBase *font = (FontBase*) getObject("font");
   font->render(*renderer, transform, bounds, color, text.c_str());
+  return true;
 }
 
 void TextField::setText(const char *text)
 {
   this->text = std::string(text);
+  changed = true;
 }
 
 const char * TextField::getText()
@@ -1,4 +1,5 @@
 #include "Texture.hpp"
+#include "DrawList.hpp"
 
 using namespace RubyAction;
 
@@ -13,9 +14,21 @@ Texture::Texture(mrb_value self, const char *filename)
   height = size.y;
 }
 
+const sf::Texture& Texture::getTexture()
+{
+  return texture;
+}
+
 void Texture::render(sf::RenderTarget &target, const sf::Transform &transform, const sf::IntRect &rect,
   const sf::Color &color)
 {
+  DrawList *list = DrawList::getRecording();
+  if (list)
+  {
+    list->addQuad(this, texture, transform, rect, color);
+    return;
+  }
+
   sprite.setColor(color);
   sprite.setTextureRect(rect);
   target.draw(sprite, transform);
@@ -6,9 +6,14 @@
 
 using namespace RubyAction;
 
-TextureRegion::TextureRegion(mrb_value self, int x, int y, int width, int height)
-  : RubyObject(self)
+// Objects keep the native objects they draw with, so rendering doesn't go through the interpreter. The Ruby
+// objects stay referenced from the properties, which the GC marks along with their owner and which scripts
+// can't reassign.
+TextureRegion::TextureRegion(mrb_value self, mrb_value textureBase, int x, int y, int width, int height)
+  : RubyObject(self),
+    textureBase(unwrap<TextureBase>(textureBase))
 {
+  setProperty("texture_base", textureBase);
   setRegion(x, y, width, height);
 }
 
@@ -42,7 +47,7 @@ void TextureRegion::setRegion(int x, int y, int width, int height)
 
 TextureBase* TextureRegion::getTextureBase()
 {
-  return (TextureBase*) getObject("texture_base");
+  return textureBase;
 }
 
 static mrb_value TextureRegion_initialize(mrb_state *mrb, mrb_value self)
@@ -57,8 +62,6 @@ static mrb_value TextureRegion_initialize(mrb_state *mrb, mrb_value self)
   RClass *clazz = RubyEngine::getInstance()->getClass("TextureBase");
   if (!mrb_obj_is_kind_of(mrb, tex, clazz)) mrb_raise(mrb, E_TYPE_ERROR, "expected TextureBase");
 
-  mrb_iv_set(mrb, self, mrb_intern(mrb, "texture_base"), tex);
-
   TextureBase* texture = unwrap<TextureBase>(tex);
 
   if (argc < 2) x = 0;
@@ -66,7 +69,7 @@ static mrb_value TextureRegion_initialize(mrb_state *mrb, mrb_value self)
   if (argc < 4) width = texture->getWidth() - x;
   if (argc < 5) height = texture->getHeight() - y;
 
-  wrap(self, new TextureRegion(self, x, y, width, height));
+  wrap(self, new TextureRegion(self, tex, x, y, width, height));
   return self;
 }
 
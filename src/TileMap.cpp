@@ -0,0 +1,233 @@
+#include "TileMap.hpp"
+#include "TextureRegion.hpp"
+#include "DrawList.hpp"
+#include "util/array.hpp"
+#include <mruby/array.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace RubyAction;
+
+TileMap::TileMap(mrb_value self, mrb_value tileset, int tileWidth, int tileHeight, int columns, int rows)
+  : Sprite(self),
+    tileset(unwrap<TextureRegion>(tileset)),
+    tileWidth(tileWidth),
+    tileHeight(tileHeight),
+    columns(columns),
+    rows(rows),
+    chunkColumns((columns + CHUNK_SIZE - 1) / CHUNK_SIZE),
+    chunkRows((rows + CHUNK_SIZE - 1) / CHUNK_SIZE),
+    tiles(columns * rows, 0),
+    chunks(chunkColumns * chunkRows),
+    builtColor(getColor())
+{
+  setProperty("tileset", tileset);
+  setWidth(columns * tileWidth);
+  setHeight(rows * tileHeight);
+  invalidateChunks();
+}
+
+int TileMap::getColumns()
+{
+  return columns;
+}
+
+int TileMap::getRows()
+{
+  return rows;
+}
+
+int TileMap::getTile(int column, int row)
+{
+  if (column < 0 || column >= columns || row < 0 || row >= rows) return 0;
+  return tiles[row * columns + column];
+}
+
+void TileMap::setTile(int column, int row, int tile)
+{
+  if (column < 0 || column >= columns || row < 0 || row >= rows) return;
+
+  int &current = tiles[row * columns + column];
+  if (current == tile) return;
+
+  current = tile;
+  invalidateChunk(column / CHUNK_SIZE, row / CHUNK_SIZE);
+}
+
+void TileMap::setTiles(const std::vector<int> &tiles)
+{
+  std::copy(tiles.begin(), tiles.begin() + std::min(tiles.size(), this->tiles.size()), this->tiles.begin());
+  invalidateChunks();
+}
+
+void TileMap::invalidateChunk(int chunkColumn, int chunkRow)
+{
+  chunks[chunkRow * chunkColumns + chunkColumn].dirty = true;
+  changed = true;
+}
+
+void TileMap::invalidateChunks()
+{
+  for (std::vector<Chunk>::iterator chunk = chunks.begin(); chunk != chunks.end(); ++chunk)
+  {
+    chunk->dirty = true;
+  }
+  changed = true;
+}
+
+// Tiles are numbered from 1, left to right and top to bottom across the tileset region; 0 is an empty cell.
+void TileMap::buildChunk(int chunkColumn, int chunkRow)
+{
+  Chunk &chunk = chunks[chunkRow * chunkColumns + chunkColumn];
+  chunk.vertices.setPrimitiveType(sf::Quads);
+  chunk.vertices.clear();
+  chunk.dirty = false;
+
+  int tilesPerRow = tileset->getWidth() / tileWidth;
+  if (tilesPerRow <= 0) return;
+
+  int firstColumn = chunkColumn * CHUNK_SIZE;
+  int firstRow = chunkRow * CHUNK_SIZE;
+  int lastColumn = std::min(firstColumn + CHUNK_SIZE, columns);
+  int lastRow = std::min(firstRow + CHUNK_SIZE, rows);
+
+  for (int row = firstRow; row < lastRow; row++)
+  {
+    for (int column = firstColumn; column < lastColumn; column++)
+    {
+      int tile = tiles[row * columns + column];
+      if (tile <= 0) continue;
+
+      float tu = tileset->getX() + ((tile - 1) % tilesPerRow) * tileWidth;
+      float tv = tileset->getY() + ((tile - 1) / tilesPerRow) * tileHeight;
+      float x = column * tileWidth;
+      float y = row * tileHeight;
+
+      chunk.vertices.append(sf::Vertex(sf::Vector2f(x, y), builtColor, sf::Vector2f(tu, tv)));
+      chunk.vertices.append(sf::Vertex(sf::Vector2f(x + tileWidth, y), builtColor, sf::Vector2f(tu + tileWidth, tv)));
+      chunk.vertices.append(sf::Vertex(sf::Vector2f(x + tileWidth, y + tileHeight), builtColor,
+        sf::Vector2f(tu + tileWidth, tv + tileHeight)));
+      chunk.vertices.append(sf::Vertex(sf::Vector2f(x, y + tileHeight), builtColor, sf::Vector2f(tu, tv + tileHeight)));
+    }
+  }
+}
+
+bool TileMap::renderMe(sf::RenderTarget *renderer, const sf::Transform &transform)
+{
+  if (getColor() != builtColor)
+  {
+    builtColor = getColor();
+    invalidateChunks();
+  }
+
+  TextureBase *texture = tileset->getTextureBase();
+  sf::RenderStates states(&texture->getTexture());
+  states.transform = transform;
+  DrawList *list = DrawList::getRecording();
+
+  // only the chunks overlapping the view, mapped back into map coordinates, are built and drawn
+  sf::FloatRect visible = transform.getInverse().transformRect(getViewport(renderer));
+
+  float chunkWidth = float(tileWidth * CHUNK_SIZE);
+  float chunkHeight = float(tileHeight * CHUNK_SIZE);
+  int firstColumn = std::max(0, int(std::floor(visible.left / chunkWidth)));
+  int firstRow = std::max(0, int(std::floor(visible.top / chunkHeight)));
+  int lastColumn = std::min(chunkColumns - 1, int(std::floor((visible.left + visible.width) / chunkWidth)));
+  int lastRow = std::min(chunkRows - 1, int(std::floor((visible.top + visible.height) / chunkHeight)));
+  bool drawn = false;
+
+  for (int chunkRow = firstRow; chunkRow <= lastRow; chunkRow++)
+  {
+    for (int chunkColumn = firstColumn; chunkColumn <= lastColumn; chunkColumn++)
+    {
+      Chunk &chunk = chunks[chunkRow * chunkColumns + chunkColumn];
+      if (chunk.dirty) buildChunk(chunkColumn, chunkRow);
+      if (chunk.vertices.getVertexCount() == 0) continue;
+      if (list)
+        list->addVertices(texture, states.texture, transform, chunk.vertices);
+      else
+        renderer->draw(chunk.vertices, states);
+      drawn = true;
+    }
+  }
+  return drawn;
+}
+
+static std::vector<int> toTiles(mrb_state *mrb, mrb_value array)
+{
+  std::vector<int> tiles(A_SIZE(array));
+  for (size_t i = 0; i < tiles.size(); i++)
+  {
+    tiles[i] = A_GET_INT(array, i);
+  }
+  return tiles;
+}
+
+static mrb_value TileMap_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_value tileset;
+  mrb_int tileWidth;
+  mrb_int tileHeight;
+  mrb_int columns;
+  mrb_int rows;
+  mrb_value tiles;
+  int argc = mrb_get_args(mrb, "oiiii|A", &tileset, &tileWidth, &tileHeight, &columns, &rows, &tiles);
+
+  RubyEngine *engine = RubyEngine::getInstance();
+  if (!mrb_obj_is_kind_of(mrb, tileset, engine->getClass("TextureRegion")))
+    mrb_raise(mrb, E_TYPE_ERROR, "expected TextureRegion");
+  if (tileWidth <= 0 || tileHeight <= 0 || columns <= 0 || rows <= 0)
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "tile size and map size must be positive");
+
+  TileMap *map = new TileMap(self, tileset, tileWidth, tileHeight, columns, rows);
+  wrap(self, map);
+  if (argc > 5) map->setTiles(toTiles(mrb, tiles));
+  return self;
+}
+
+static mrb_value TileMap_getColumns(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(unwrap<TileMap>(self)->getColumns());
+}
+
+static mrb_value TileMap_getRows(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(unwrap<TileMap>(self)->getRows());
+}
+
+static mrb_value TileMap_getTile(mrb_state *mrb, mrb_value self)
+{
+  mrb_int column, row;
+  mrb_get_args(mrb, "ii", &column, &row);
+  return mrb_fixnum_value(unwrap<TileMap>(self)->getTile(column, row));
+}
+
+static mrb_value TileMap_setTile(mrb_state *mrb, mrb_value self)
+{
+  mrb_int column, row, tile;
+  mrb_get_args(mrb, "iii", &column, &row, &tile);
+  unwrap<TileMap>(self)->setTile(column, row, tile);
+  return mrb_fixnum_value(tile);
+}
+
+static mrb_value TileMap_setTiles(mrb_state *mrb, mrb_value self)
+{
+  mrb_value tiles;
+  mrb_get_args(mrb, "A", &tiles);
+  unwrap<TileMap>(self)->setTiles(toTiles(mrb, tiles));
+  return self;
+}
+
+void RubyAction::bindTileMap(mrb_state *mrb, RClass *module)
+{
+  struct RClass *super = mrb_class_get_under(mrb, module, "Sprite");
+  struct RClass *clazz = mrb_define_class_under(mrb, module, "TileMap", super);
+  MRB_SET_INSTANCE_TT(clazz, MRB_TT_DATA);
+
+  mrb_define_method(mrb, clazz, "initialize", TileMap_initialize, MRB_ARGS_ARG(5, 1));
+  mrb_define_method(mrb, clazz, "columns", TileMap_getColumns, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "rows", TileMap_getRows, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "[]", TileMap_getTile, MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, clazz, "[]=", TileMap_setTile, MRB_ARGS_REQ(3));
+  mrb_define_method(mrb, clazz, "tiles=", TileMap_setTiles, MRB_ARGS_REQ(1));
+}
@@ -1,4 +1,6 @@
 #include "physics/Body.hpp"
+#include "physics/Fixture.hpp"
+#include "physics/World.hpp"
 #include "util/array.hpp"
 #include "util/hash.hpp"
 #include <mruby/hash.h>
@@ -7,82 +9,117 @@
 using namespace RubyAction;
 using namespace RubyAction::Physics;
 
-Body::Body(b2World* world, mrb_value hash)
-  : RubyObject(mrb_nil_value())
+Body::Body(b2World* world, const b2BodyDef& bodyDef)
+  : EventDispatcher(mrb_nil_value()),
+    sprite(NULL),
+    previousAngle(0)
 {
   RubyEngine *engine = RubyEngine::getInstance();
   RClass *clazz = mrb_class_get_under(mrb, engine->getClass("Physics"), "Body");
   this->self = engine->newInstance(clazz, NULL, 0, false);
+  wrap(self, this);
+  setProperty("listeners", mrb_hash_new(mrb));
+  setProperty("fixtures", mrb_ary_new(mrb));
 
-  b2BodyDef def;
+  b2BodyDef def = bodyDef;
+  def.userData = this;
+  this->body = world->CreateBody(&def);
+  saveTransform();
+}
 
+void Body::readDef(mrb_state *mrb, mrb_value hash, b2BodyDef *def)
+{
   mrb_value type = H_GET_VALUE_DEF(hash, "type", mrb_fixnum_value(b2_dynamicBody));
   switch (mrb_fixnum(type)) {
-    case 0: def.type = b2_staticBody; break;
-    case 1: def.type = b2_kinematicBody; break;
-    case 2: def.type = b2_dynamicBody;
+    case 0: def->type = b2_staticBody; break;
+    case 1: def->type = b2_kinematicBody; break;
+    case 2: def->type = b2_dynamicBody;
   }
 
   mrb_value position = H_GET_VALUE(hash, "position");
-  if (!mrb_nil_p(position)) def.position.Set(
+  if (!mrb_nil_p(position)) def->position.Set(
     A_GET_FLOAT(position, 0),
     A_GET_FLOAT(position, 1)
   );
 
   mrb_value angle = H_GET_VALUE(hash, "angle");
-  if (!mrb_nil_p(angle)) def.angle = TO_FLOAT(angle);
+  if (!mrb_nil_p(angle)) def->angle = TO_FLOAT(angle);
 
   mrb_value linearVelocity = H_GET_VALUE(hash, "linear_velocity");
-  if (!mrb_nil_p(linearVelocity)) def.linearVelocity.Set(
+  if (!mrb_nil_p(linearVelocity)) def->linearVelocity.Set(
     A_GET_FLOAT(linearVelocity, 0),
     A_GET_FLOAT(linearVelocity, 1)
   );
 
   mrb_value angularVelocity = H_GET_VALUE(hash, "angular_velocity");
-  if (!mrb_nil_p(angularVelocity)) def.angularVelocity = TO_FLOAT(angularVelocity);
+  if (!mrb_nil_p(angularVelocity)) def->angularVelocity = TO_FLOAT(angularVelocity);
 
   mrb_value linearDamping = H_GET_VALUE(hash, "linear_damping");
-  if (!mrb_nil_p(linearDamping)) def.linearDamping = TO_FLOAT(linearDamping);
+  if (!mrb_nil_p(linearDamping)) def->linearDamping = TO_FLOAT(linearDamping);
 
   mrb_value angularDamping = H_GET_VALUE(hash, "angular_damping");
-  if (!mrb_nil_p(angularDamping)) def.angularDamping = TO_FLOAT(angularDamping);
+  if (!mrb_nil_p(angularDamping)) def->angularDamping = TO_FLOAT(angularDamping);
 
   mrb_value allowSleep = H_GET_VALUE(hash, "allow_sleep");
-  if (!mrb_nil_p(allowSleep)) def.allowSleep = mrb_bool(allowSleep);
+  if (!mrb_nil_p(allowSleep)) def->allowSleep = mrb_bool(allowSleep);
 
   mrb_value awake = H_GET_VALUE(hash, "awake");
-  if (!mrb_nil_p(awake)) def.awake = mrb_bool(awake);
+  if (!mrb_nil_p(awake)) def->awake = mrb_bool(awake);
 
   mrb_value fixedRotation = H_GET_VALUE(hash, "fixed_rotation");
-  if (!mrb_nil_p(fixedRotation)) def.fixedRotation = mrb_bool(fixedRotation);
+  if (!mrb_nil_p(fixedRotation)) def->fixedRotation = mrb_bool(fixedRotation);
 
   mrb_value bullet = H_GET_VALUE(hash, "bullet");
-  if (!mrb_nil_p(bullet)) def.bullet = mrb_bool(bullet);
+  if (!mrb_nil_p(bullet)) def->bullet = mrb_bool(bullet);
 
   mrb_value active = H_GET_VALUE(hash, "active");
-  if (!mrb_nil_p(active)) def.active = mrb_bool(active);
+  if (!mrb_nil_p(active)) def->active = mrb_bool(active);
 
   mrb_value gravityScale = H_GET_VALUE(hash, "gravity_scale");
-  if (!mrb_nil_p(gravityScale)) def.gravityScale = TO_FLOAT(gravityScale);
+  if (!mrb_nil_p(gravityScale)) def->gravityScale = TO_FLOAT(gravityScale);
+}
 
-  this->body = world->CreateBody(&def);
+b2Body* Body::getBody()
+{
+  return body;
+}
 
-  // b2CircleShape circle;
-  // circle.m_radius = 60;
-  // this->body->CreateFixture(&circle, 1);
+Fixture* Body::createFixture(const FixtureDef& def)
+{
+  Fixture *fixture = new Fixture(this, def);
+  mrb_ary_push(mrb, getProperty("fixtures"), fixture->getSelf());
+  return fixture;
+}
 
-  // b2PolygonShape box;
-  // box.SetAsBox(80, 40);
-  // b2Fixture *fixture = this->body->CreateFixture(&box, 1);
-  // fixture->SetRestitution(1.f);
+Sprite* Body::getSprite()
+{
+  return sprite;
+}
+
+void Body::setSprite(mrb_value sprite)
+{
+  setProperty("sprite", sprite);
+  this->sprite = mrb_nil_p(sprite) ? NULL : unwrap<Sprite>(sprite);
+}
+
+void Body::saveTransform()
+{
+  previousPosition = body->GetPosition();
+  previousAngle = body->GetAngle();
+}
 
-  // def.type = b2_staticBody;
-  // def.position.Set(297, 300);
-  // this->body = world->CreateBody(&def);
+// Writes the body transform, blended from the previous step by alpha, into the bound sprite.
+void Body::syncSprite(float alpha, float pixelsPerMeter)
+{
+  if (!sprite) return;
 
-  // box.SetAsBox(100, 10);
-  // this->body->CreateFixture(&box, 1);
+  const b2Vec2 &position = body->GetPosition();
+  float32 angle = body->GetAngle();
+  float32 beta = 1 - alpha;
 
+  sprite->setX((previousPosition.x * beta + position.x * alpha) * pixelsPerMeter);
+  sprite->setY((previousPosition.y * beta + position.y * alpha) * pixelsPerMeter);
+  sprite->setRotation((previousAngle * beta + angle * alpha) * 180 / b2_pi);
 }
 
 static mrb_value Body_initialize(mrb_state *mrb, mrb_value self)
@@ -91,12 +128,54 @@ static mrb_value Body_initialize(mrb_state *mrb, mrb_value self)
   return self;
 }
 
+static mrb_value Body_createFixture(mrb_state *mrb, mrb_value self)
+{
+  mrb_value hash;
+  mrb_get_args(mrb, "H", &hash);
+  FixtureDef::check(mrb, hash);
+  FixtureDef def(mrb, hash);
+  Body *body = unwrap<Body>(self);
+  World::sync(body->getBody()->GetWorld());
+  return body->createFixture(def)->getSelf();
+}
+
+static mrb_value Body_getFixtures(mrb_state *mrb, mrb_value self)
+{
+  mrb_value fixtures = unwrap<Body>(self)->getProperty("fixtures");
+  return mrb_ary_new_from_values(mrb, RARRAY_LEN(fixtures), RARRAY_PTR(fixtures));
+}
+
+static mrb_value Body_getSprite(mrb_state *mrb, mrb_value self)
+{
+  Sprite *sprite = unwrap<Body>(self)->getSprite();
+  return sprite ? sprite->getSelf() : mrb_nil_value();
+}
+
+static mrb_value Body_setSprite(mrb_state *mrb, mrb_value self)
+{
+  mrb_value sprite;
+  mrb_get_args(mrb, "o", &sprite);
+
+  if (!mrb_nil_p(sprite) && !mrb_obj_is_kind_of(mrb, sprite, RubyEngine::getInstance()->getClass("Sprite")))
+  {
+    mrb_raise(mrb, E_TYPE_ERROR, "expected Sprite");
+  }
+
+  unwrap<Body>(self)->setSprite(sprite);
+  return self;
+}
+
 void Physics::bindBody(mrb_state *mrb, RClass *module, RClass *physics)
 {
-  struct RClass *clazz = mrb_define_class_under(mrb, physics, "Body", mrb->object_class);
+  struct RClass *super = mrb_class_get_under(mrb, module, "EventDispatcher");
+  struct RClass *clazz = mrb_define_class_under(mrb, physics, "Body", super);
   MRB_SET_INSTANCE_TT(clazz, MRB_TT_DATA);
 
   mrb_define_method(mrb, clazz, "initialize", Body_initialize, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "create_fixture", Body_createFixture, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "fixtures", Body_getFixtures, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "sprite", Body_getSprite, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "sprite=", Body_setSprite, MRB_ARGS_REQ(1));
 
   mrb_define_const(mrb, clazz, "STATIC_BODY", mrb_fixnum_value(0));
   mrb_define_const(mrb, clazz, "KINEMATIC_BODY", mrb_fixnum_value(1));
@@ -0,0 +1,172 @@
+#include "physics/DebugDraw.hpp"
+#include "DrawList.hpp"
+#include <algorithm>
+
+using namespace RubyAction::Physics;
+
+std::vector<DebugDraw*> DebugDraw::instances;
+
+static const int CIRCLE_SEGMENTS = 16;
+
+static sf::Color toColor(const b2Color& color, float alpha = 1)
+{
+  return sf::Color(color.r * 255, color.g * 255, color.b * 255, alpha * 255);
+}
+
+DebugDraw::DebugDraw(b2World* world)
+  : world(world),
+    scale(1),
+    pipelined(false),
+    lines(sf::Lines),
+    triangles(sf::Triangles)
+{
+  instances.push_back(this);
+}
+
+DebugDraw::~DebugDraw()
+{
+  instances.erase(std::find(instances.begin(), instances.end(), this));
+}
+
+void DebugDraw::setScale(float scale)
+{
+  this->scale = scale;
+}
+
+void DebugDraw::setPipelined(bool pipelined)
+{
+  this->pipelined = pipelined;
+}
+
+sf::Vector2f DebugDraw::toPixels(const b2Vec2& point)
+{
+  return sf::Vector2f(point.x * scale, point.y * scale);
+}
+
+void DebugDraw::addLine(const b2Vec2& p1, const b2Vec2& p2, const sf::Color& color)
+{
+  lines.append(sf::Vertex(toPixels(p1), color));
+  lines.append(sf::Vertex(toPixels(p2), color));
+}
+
+void DebugDraw::addTriangle(const b2Vec2& p1, const b2Vec2& p2, const b2Vec2& p3, const sf::Color& color)
+{
+  triangles.append(sf::Vertex(toPixels(p1), color));
+  triangles.append(sf::Vertex(toPixels(p2), color));
+  triangles.append(sf::Vertex(toPixels(p3), color));
+}
+
+void DebugDraw::DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color)
+{
+  sf::Color outline = toColor(color);
+  for (int32 i = 0; i < vertexCount; i++)
+  {
+    addLine(vertices[i], vertices[(i + 1) % vertexCount], outline);
+  }
+}
+
+void DebugDraw::DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color)
+{
+  sf::Color fill = toColor(color, 0.5f);
+  for (int32 i = 1; i < vertexCount - 1; i++)
+  {
+    addTriangle(vertices[0], vertices[i], vertices[i + 1], fill);
+  }
+  DrawPolygon(vertices, vertexCount, color);
+}
+
+void DebugDraw::DrawCircle(const b2Vec2& center, float32 radius, const b2Color& color)
+{
+  sf::Color outline = toColor(color);
+  b2Vec2 previous = center + b2Vec2(radius, 0);
+  for (int i = 1; i <= CIRCLE_SEGMENTS; i++)
+  {
+    float32 angle = 2 * b2_pi * i / CIRCLE_SEGMENTS;
+    b2Vec2 next = center + radius * b2Vec2(cosf(angle), sinf(angle));
+    addLine(previous, next, outline);
+    previous = next;
+  }
+}
+
+void DebugDraw::DrawSolidCircle(const b2Vec2& center, float32 radius, const b2Vec2& axis, const b2Color& color)
+{
+  sf::Color fill = toColor(color, 0.5f);
+  b2Vec2 previous = center + b2Vec2(radius, 0);
+  for (int i = 1; i <= CIRCLE_SEGMENTS; i++)
+  {
+    float32 angle = 2 * b2_pi * i / CIRCLE_SEGMENTS;
+    b2Vec2 next = center + radius * b2Vec2(cosf(angle), sinf(angle));
+    addTriangle(center, previous, next, fill);
+    previous = next;
+  }
+  DrawCircle(center, radius, color);
+  addLine(center, center + radius * axis, toColor(color));
+}
+
+void DebugDraw::DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color)
+{
+  addLine(p1, p2, toColor(color));
+}
+
+void DebugDraw::DrawTransform(const b2Transform& xf)
+{
+  const float32 axisScale = 0.4f;
+  addLine(xf.p, xf.p + axisScale * xf.q.GetXAxis(), sf::Color::Red);
+  addLine(xf.p, xf.p + axisScale * xf.q.GetYAxis(), sf::Color::Green);
+}
+
+// Marks the points of touching contacts with a small cross and their normal.
+void DebugDraw::drawContacts()
+{
+  const float32 size = 3 / scale;
+  const float32 normalLength = 12 / scale;
+  sf::Color pointColor(255, 64, 64);
+  sf::Color normalColor(64, 255, 64);
+
+  for (b2Contact *contact = world->GetContactList(); contact; contact = contact->GetNext())
+  {
+    if (!contact->IsTouching()) continue;
+
+    b2WorldManifold manifold;
+    contact->GetWorldManifold(&manifold);
+    for (int32 i = 0; i < contact->GetManifold()->pointCount; i++)
+    {
+      const b2Vec2& point = manifold.points[i];
+      addLine(point - b2Vec2(size, size), point + b2Vec2(size, size), pointColor);
+      addLine(point - b2Vec2(size, -size), point + b2Vec2(size, -size), pointColor);
+      addLine(point, point + normalLength * manifold.normal, normalColor);
+    }
+  }
+}
+
+void DebugDraw::collect()
+{
+  lines.clear();
+  triangles.clear();
+  world->DrawDebugData();
+  if (GetFlags() & e_contactBit) drawContacts();
+}
+
+void DebugDraw::render(sf::RenderTarget* target)
+{
+  if (!pipelined) collect();
+
+  DrawList *list = DrawList::getRecording();
+  if (list)
+  {
+    list->addVertices(NULL, NULL, sf::Transform::Identity, triangles);
+    list->addVertices(NULL, NULL, sf::Transform::Identity, lines);
+    return;
+  }
+
+  target->draw(triangles);
+  target->draw(lines);
+}
+
+void DebugDraw::renderAll(sf::RenderTarget* target)
+{
+  for (std::vector<DebugDraw*>::iterator instance = instances.begin(); instance != instances.end(); ++instance)
+  {
+    (*instance)->render(target);
+  }
+}
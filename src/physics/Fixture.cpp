@@ -0,0 +1,321 @@
+#include "physics/Fixture.hpp"
+#include "physics/Body.hpp"
+#include "physics/World.hpp"
+#include "util/array.hpp"
+#include "util/hash.hpp"
+#include <mruby/hash.h>
+#include <mruby/array.h>
+#include <vector>
+
+using namespace RubyAction;
+using namespace RubyAction::Physics;
+
+// vertices are packed as [x0, y0, x1, y1, ...]
+static std::vector<b2Vec2> readVertices(mrb_state *mrb, mrb_value hash)
+{
+  mrb_value vertices = H_GET_VALUE(hash, "vertices");
+  std::vector<b2Vec2> points(A_SIZE(vertices) / 2);
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    points[i].Set(A_GET_FLOAT(vertices, i * 2), A_GET_FLOAT(vertices, i * 2 + 1));
+  }
+  return points;
+}
+
+// Raises unless the value at key is an [x, y] pair of numbers, or nil when it is optional.
+static void checkPair(mrb_state *mrb, mrb_value hash, const char *key, bool optional)
+{
+  mrb_value pair = H_GET_VALUE(hash, key);
+  if (optional && mrb_nil_p(pair)) return;
+  if (!mrb_array_p(pair) || A_SIZE(pair) < 2) mrb_raisef(mrb, E_ARGUMENT_ERROR, "expected %s: [x, y]", key);
+  (void) A_GET_FLOAT(pair, 0);
+  (void) A_GET_FLOAT(pair, 1);
+}
+
+// Raises unless the value at key is a number or nil.
+static void checkFloat(mrb_state *mrb, mrb_value hash, const char *key)
+{
+  mrb_value value = H_GET_VALUE(hash, key);
+  if (!mrb_nil_p(value)) (void) TO_FLOAT(value);
+}
+
+// Raises unless the value at key is an integer or nil.
+static void checkInt(mrb_state *mrb, mrb_value hash, const char *key)
+{
+  mrb_value value = H_GET_VALUE(hash, key);
+  if (!mrb_nil_p(value)) (void) TO_INT(value);
+}
+
+// Raises unless the vertices are numbers, and returns how many points they make.
+static size_t checkVertices(mrb_state *mrb, mrb_value hash)
+{
+  mrb_value vertices = H_GET_VALUE(hash, "vertices");
+  if (!mrb_array_p(vertices)) mrb_raise(mrb, E_ARGUMENT_ERROR, "expected vertices: [x0, y0, x1, y1, ...]");
+
+  size_t count = A_SIZE(vertices) / 2;
+  for (size_t i = 0; i < count * 2; i++)
+  {
+    (void) A_GET_FLOAT(vertices, i);
+  }
+  return count;
+}
+
+void FixtureDef::check(mrb_state *mrb, mrb_value hash)
+{
+  if (!mrb_hash_p(hash)) mrb_raise(mrb, E_TYPE_ERROR, "expected a Hash for a fixture");
+
+  mrb_value type = H_GET_VALUE_DEF(hash, "type", mrb_fixnum_value(CIRCLE_SHAPE));
+  if (!mrb_fixnum_p(type)) mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown shape type");
+
+  switch (mrb_fixnum(type)) {
+    case CIRCLE_SHAPE:
+      checkFloat(mrb, hash, "radius");
+      checkPair(mrb, hash, "position", true);
+      break;
+    case POLYGON_SHAPE:
+      if (!mrb_nil_p(H_GET_VALUE(hash, "box")))
+      {
+        checkPair(mrb, hash, "box", false);
+        checkPair(mrb, hash, "position", true);
+        checkFloat(mrb, hash, "angle");
+      }
+      else
+      {
+        size_t count = checkVertices(mrb, hash);
+        if (count < 3 || count > (size_t) b2_maxPolygonVertices)
+          mrb_raisef(mrb, E_ARGUMENT_ERROR, "a polygon needs between 3 and %d vertices", b2_maxPolygonVertices);
+      }
+      break;
+    case EDGE_SHAPE:
+      if (checkVertices(mrb, hash) != 2) mrb_raise(mrb, E_ARGUMENT_ERROR, "an edge needs 2 vertices");
+      break;
+    case CHAIN_SHAPE:
+      if (checkVertices(mrb, hash) < 2) mrb_raise(mrb, E_ARGUMENT_ERROR, "a chain needs at least 2 vertices");
+      break;
+    default:
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown shape type");
+  }
+
+  checkFloat(mrb, hash, "density");
+  checkFloat(mrb, hash, "friction");
+  checkFloat(mrb, hash, "restitution");
+  checkInt(mrb, hash, "category_bits");
+  checkInt(mrb, hash, "mask_bits");
+  checkInt(mrb, hash, "group_index");
+}
+
+// The hash has been checked, so nothing here raises while the shapes and vertices are alive.
+FixtureDef::FixtureDef(mrb_state *mrb, mrb_value hash)
+{
+  mrb_value type = H_GET_VALUE_DEF(hash, "type", mrb_fixnum_value(CIRCLE_SHAPE));
+  switch (mrb_fixnum(type)) {
+    case CIRCLE_SHAPE:
+    {
+      circle.m_radius = TO_FLOAT(H_GET_VALUE_DEF(hash, "radius", mrb_float_value(mrb, 1)));
+      mrb_value position = H_GET_VALUE(hash, "position");
+      if (!mrb_nil_p(position)) circle.m_p.Set(A_GET_FLOAT(position, 0), A_GET_FLOAT(position, 1));
+      def.shape = &circle;
+      break;
+    }
+    case POLYGON_SHAPE:
+    {
+      mrb_value box = H_GET_VALUE(hash, "box");
+      if (!mrb_nil_p(box))
+      {
+        mrb_value center = H_GET_VALUE(hash, "position");
+        mrb_value angle = H_GET_VALUE(hash, "angle");
+        polygon.SetAsBox(A_GET_FLOAT(box, 0) / 2, A_GET_FLOAT(box, 1) / 2,
+          mrb_nil_p(center) ? b2Vec2(0, 0) : b2Vec2(A_GET_FLOAT(center, 0), A_GET_FLOAT(center, 1)),
+          mrb_nil_p(angle) ? 0 : TO_FLOAT(angle));
+      }
+      else
+      {
+        std::vector<b2Vec2> points = readVertices(mrb, hash);
+        polygon.Set(&points[0], points.size());
+      }
+      def.shape = &polygon;
+      break;
+    }
+    case EDGE_SHAPE:
+    {
+      std::vector<b2Vec2> points = readVertices(mrb, hash);
+      edge.Set(points[0], points[1]);
+      def.shape = &edge;
+      break;
+    }
+    case CHAIN_SHAPE:
+    {
+      std::vector<b2Vec2> points = readVertices(mrb, hash);
+      if (mrb_test(H_GET_VALUE(hash, "loop"))) chain.CreateLoop(&points[0], points.size());
+      else chain.CreateChain(&points[0], points.size());
+      def.shape = &chain;
+      break;
+    }
+  }
+
+  mrb_value density = H_GET_VALUE(hash, "density");
+  if (!mrb_nil_p(density)) def.density = TO_FLOAT(density);
+
+  mrb_value friction = H_GET_VALUE(hash, "friction");
+  if (!mrb_nil_p(friction)) def.friction = TO_FLOAT(friction);
+
+  mrb_value restitution = H_GET_VALUE(hash, "restitution");
+  if (!mrb_nil_p(restitution)) def.restitution = TO_FLOAT(restitution);
+
+  mrb_value sensor = H_GET_VALUE(hash, "sensor");
+  if (!mrb_nil_p(sensor)) def.isSensor = mrb_bool(sensor);
+
+  mrb_value categoryBits = H_GET_VALUE(hash, "category_bits");
+  if (!mrb_nil_p(categoryBits)) def.filter.categoryBits = TO_INT(categoryBits);
+
+  mrb_value maskBits = H_GET_VALUE(hash, "mask_bits");
+  if (!mrb_nil_p(maskBits)) def.filter.maskBits = TO_INT(maskBits);
+
+  mrb_value groupIndex = H_GET_VALUE(hash, "group_index");
+  if (!mrb_nil_p(groupIndex)) def.filter.groupIndex = TO_INT(groupIndex);
+}
+
+Fixture::Fixture(Body* body, const FixtureDef& fixtureDef)
+  : RubyObject(mrb_nil_value())
+{
+  RubyEngine *engine = RubyEngine::getInstance();
+  RClass *clazz = mrb_class_get_under(mrb, engine->getClass("Physics"), "Fixture");
+  this->self = engine->newInstance(clazz, NULL, 0, false);
+  wrap(self, this);
+  setProperty("body", body->getSelf());
+
+  b2FixtureDef def = fixtureDef.def;
+  def.userData = this;
+  this->fixture = body->getBody()->CreateFixture(&def);
+}
+
+b2Fixture* Fixture::getFixture()
+{
+  return fixture;
+}
+
+Body* Fixture::getBody()
+{
+  return (Body*) fixture->GetBody()->GetUserData();
+}
+
+static mrb_value Fixture_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_raise(mrb, E_RUNTIME_ERROR, "Wrong use of this class. Try RubyAction::Physics::Body.create_fixture");
+  return self;
+}
+
+static mrb_value Fixture_getBody(mrb_state *mrb, mrb_value self)
+{
+  return unwrap<Fixture>(self)->getBody()->getSelf();
+}
+
+static mrb_value Fixture_getDensity(mrb_state *mrb, mrb_value self)
+{
+  return mrb_float_value(mrb, unwrap<Fixture>(self)->getFixture()->GetDensity());
+}
+
+// Unwraps a fixture about to be changed, once its world is not being stepped on a stepper thread.
+static b2Fixture* changing(mrb_value self)
+{
+  b2Fixture *fixture = unwrap<Fixture>(self)->getFixture();
+  World::sync(fixture->GetBody()->GetWorld());
+  return fixture;
+}
+
+static mrb_value Fixture_setDensity(mrb_state *mrb, mrb_value self)
+{
+  mrb_float density;
+  mrb_get_args(mrb, "f", &density);
+  b2Fixture *fixture = changing(self);
+  fixture->SetDensity(density);
+  fixture->GetBody()->ResetMassData();
+  return self;
+}
+
+static mrb_value Fixture_getFriction(mrb_state *mrb, mrb_value self)
+{
+  return mrb_float_value(mrb, unwrap<Fixture>(self)->getFixture()->GetFriction());
+}
+
+static mrb_value Fixture_setFriction(mrb_state *mrb, mrb_value self)
+{
+  mrb_float friction;
+  mrb_get_args(mrb, "f", &friction);
+  changing(self)->SetFriction(friction);
+  return self;
+}
+
+static mrb_value Fixture_getRestitution(mrb_state *mrb, mrb_value self)
+{
+  return mrb_float_value(mrb, unwrap<Fixture>(self)->getFixture()->GetRestitution());
+}
+
+static mrb_value Fixture_setRestitution(mrb_state *mrb, mrb_value self)
+{
+  mrb_float restitution;
+  mrb_get_args(mrb, "f", &restitution);
+  changing(self)->SetRestitution(restitution);
+  return self;
+}
+
+static mrb_value Fixture_isSensor(mrb_state *mrb, mrb_value self)
+{
+  return mrb_bool_value(unwrap<Fixture>(self)->getFixture()->IsSensor());
+}
+
+static mrb_value Fixture_setSensor(mrb_state *mrb, mrb_value self)
+{
+  mrb_bool sensor;
+  mrb_get_args(mrb, "b", &sensor);
+  changing(self)->SetSensor(sensor);
+  return self;
+}
+
+static mrb_value Fixture_getFilter(mrb_state *mrb, mrb_value self)
+{
+  const b2Filter &filter = unwrap<Fixture>(self)->getFixture()->GetFilterData();
+  mrb_value values[3] = {
+    mrb_fixnum_value(filter.categoryBits),
+    mrb_fixnum_value(filter.maskBits),
+    mrb_fixnum_value(filter.groupIndex)
+  };
+  return mrb_ary_new_from_values(mrb, 3, values);
+}
+
+static mrb_value Fixture_setFilter(mrb_state *mrb, mrb_value self)
+{
+  mrb_value values;
+  mrb_get_args(mrb, "A", &values);
+
+  b2Filter filter;
+  filter.categoryBits = A_GET_INT(values, 0);
+  filter.maskBits = A_GET_INT(values, 1);
+  filter.groupIndex = A_GET_INT(values, 2);
+  changing(self)->SetFilterData(filter);
+  return self;
+}
+
+void Physics::bindFixture(mrb_state *mrb, RClass *module, RClass *physics)
+{
+  struct RClass *clazz = mrb_define_class_under(mrb, physics, "Fixture", mrb->object_class);
+  MRB_SET_INSTANCE_TT(clazz, MRB_TT_DATA);
+
+  mrb_define_method(mrb, clazz, "initialize", Fixture_initialize, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "body", Fixture_getBody, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "density", Fixture_getDensity, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "density=", Fixture_setDensity, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "friction", Fixture_getFriction, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "friction=", Fixture_setFriction, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "restitution", Fixture_getRestitution, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "restitution=", Fixture_setRestitution, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "sensor?", Fixture_isSensor, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "sensor=", Fixture_setSensor, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "filter", Fixture_getFilter, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "filter=", Fixture_setFilter, MRB_ARGS_REQ(1));
+
+  mrb_define_const(mrb, clazz, "CIRCLE", mrb_fixnum_value(CIRCLE_SHAPE));
+  mrb_define_const(mrb, clazz, "POLYGON", mrb_fixnum_value(POLYGON_SHAPE));
+  mrb_define_const(mrb, clazz, "EDGE", mrb_fixnum_value(EDGE_SHAPE));
+  mrb_define_const(mrb, clazz, "CHAIN", mrb_fixnum_value(CHAIN_SHAPE));
+}
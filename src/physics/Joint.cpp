@@ -0,0 +1,247 @@
+#include "physics/Joint.hpp"
+#include "physics/Body.hpp"
+#include "physics/World.hpp"
+#include "util/array.hpp"
+#include "util/hash.hpp"
+#include <mruby/hash.h>
+#include <mruby/array.h>
+
+using namespace RubyAction;
+using namespace RubyAction::Physics;
+
+static b2Body* readBody(mrb_state *mrb, mrb_value hash, const char *key)
+{
+  return unwrap<Body>(H_GET_VALUE(hash, key))->getBody();
+}
+
+static b2Vec2 readVector(mrb_state *mrb, mrb_value hash, const char *key, const b2Vec2 &def)
+{
+  mrb_value vector = H_GET_VALUE(hash, key);
+  return mrb_nil_p(vector) ? def : b2Vec2(A_GET_FLOAT(vector, 0), A_GET_FLOAT(vector, 1));
+}
+
+static float32 readFloat(mrb_state *mrb, mrb_value hash, const char *key, float32 def)
+{
+  mrb_value value = H_GET_VALUE(hash, key);
+  return mrb_nil_p(value) ? def : TO_FLOAT(value);
+}
+
+static bool readBool(mrb_state *mrb, mrb_value hash, const char *key, bool def)
+{
+  mrb_value value = H_GET_VALUE(hash, key);
+  return mrb_nil_p(value) ? def : mrb_bool(value);
+}
+
+static b2Body* checkBody(mrb_state *mrb, mrb_value hash, const char *key)
+{
+  mrb_value body = H_GET_VALUE(hash, key);
+  RClass *clazz = mrb_class_get_under(mrb, RubyEngine::getInstance()->getClass("Physics"), "Body");
+  if (!mrb_obj_is_kind_of(mrb, body, clazz)) mrb_raisef(mrb, E_TYPE_ERROR, "expected Body for %s", key);
+  return unwrap<Body>(body)->getBody();
+}
+
+// Raises unless the value at key is nil or an [x, y] pair of numbers.
+static void checkVector(mrb_state *mrb, mrb_value hash, const char *key)
+{
+  mrb_value vector = H_GET_VALUE(hash, key);
+  if (mrb_nil_p(vector)) return;
+  if (!mrb_array_p(vector) || A_SIZE(vector) < 2) mrb_raisef(mrb, E_ARGUMENT_ERROR, "expected %s: [x, y]", key);
+  (void) A_GET_FLOAT(vector, 0);
+  (void) A_GET_FLOAT(vector, 1);
+}
+
+void Joint::check(mrb_state *mrb, b2World* world, mrb_value hash)
+{
+  b2Body *bodyA = checkBody(mrb, hash, "body_a");
+  b2Body *bodyB = checkBody(mrb, hash, "body_b");
+  if (bodyA->GetWorld() != world || bodyB->GetWorld() != world)
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "a joint needs bodies of its own world");
+  if (bodyA == bodyB) mrb_raise(mrb, E_ARGUMENT_ERROR, "a joint needs two different bodies");
+
+  mrb_value type = H_GET_VALUE_DEF(hash, "type", mrb_fixnum_value(REVOLUTE_JOINT));
+  if (!mrb_fixnum_p(type) || mrb_fixnum(type) < DISTANCE_JOINT || mrb_fixnum(type) > ROPE_JOINT)
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown joint type");
+
+  static const char *vectors[] = { "anchor", "axis", "anchor_a", "anchor_b" };
+  for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+  {
+    checkVector(mrb, hash, vectors[i]);
+  }
+
+  static const char *floats[] = {
+    "frequency", "damping_ratio", "lower", "upper", "motor_speed",
+    "max_motor_torque", "max_motor_force", "max_length"
+  };
+  for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+  {
+    mrb_value value = H_GET_VALUE(hash, floats[i]);
+    if (!mrb_nil_p(value)) (void) TO_FLOAT(value);
+  }
+}
+
+// The hash has been checked, so nothing here raises once self wraps the joint.
+Joint::Joint(b2World* world, mrb_value hash)
+  : RubyObject(mrb_nil_value()),
+    joint(NULL)
+{
+  b2Body *bodyA = readBody(mrb, hash, "body_a");
+  b2Body *bodyB = readBody(mrb, hash, "body_b");
+
+  RubyEngine *engine = RubyEngine::getInstance();
+  RClass *clazz = mrb_class_get_under(mrb, engine->getClass("Physics"), "Joint");
+  this->self = engine->newInstance(clazz, NULL, 0, false);
+  wrap(self, this);
+  setProperty("body_a", H_GET_VALUE(hash, "body_a"));
+  setProperty("body_b", H_GET_VALUE(hash, "body_b"));
+
+  // anchors and axes are given in world coordinates
+  b2Vec2 anchor = readVector(mrb, hash, "anchor", bodyA->GetWorldCenter());
+  b2Vec2 axis = readVector(mrb, hash, "axis", b2Vec2(1, 0));
+  bool collideConnected = readBool(mrb, hash, "collide_connected", false);
+
+  mrb_value type = H_GET_VALUE_DEF(hash, "type", mrb_fixnum_value(REVOLUTE_JOINT));
+  switch (mrb_fixnum(type)) {
+    case DISTANCE_JOINT:
+    {
+      b2DistanceJointDef def;
+      def.Initialize(bodyA, bodyB,
+        readVector(mrb, hash, "anchor_a", bodyA->GetWorldCenter()),
+        readVector(mrb, hash, "anchor_b", bodyB->GetWorldCenter()));
+      def.frequencyHz = readFloat(mrb, hash, "frequency", def.frequencyHz);
+      def.dampingRatio = readFloat(mrb, hash, "damping_ratio", def.dampingRatio);
+      def.collideConnected = collideConnected;
+      joint = world->CreateJoint(&def);
+      break;
+    }
+    case REVOLUTE_JOINT:
+    {
+      b2RevoluteJointDef def;
+      def.Initialize(bodyA, bodyB, anchor);
+      def.enableLimit = readBool(mrb, hash, "enable_limit", def.enableLimit);
+      def.lowerAngle = readFloat(mrb, hash, "lower", def.lowerAngle);
+      def.upperAngle = readFloat(mrb, hash, "upper", def.upperAngle);
+      def.enableMotor = readBool(mrb, hash, "enable_motor", def.enableMotor);
+      def.motorSpeed = readFloat(mrb, hash, "motor_speed", def.motorSpeed);
+      def.maxMotorTorque = readFloat(mrb, hash, "max_motor_torque", def.maxMotorTorque);
+      def.collideConnected = collideConnected;
+      joint = world->CreateJoint(&def);
+      break;
+    }
+    case PRISMATIC_JOINT:
+    {
+      b2PrismaticJointDef def;
+      def.Initialize(bodyA, bodyB, anchor, axis);
+      def.enableLimit = readBool(mrb, hash, "enable_limit", def.enableLimit);
+      def.lowerTranslation = readFloat(mrb, hash, "lower", def.lowerTranslation);
+      def.upperTranslation = readFloat(mrb, hash, "upper", def.upperTranslation);
+      def.enableMotor = readBool(mrb, hash, "enable_motor", def.enableMotor);
+      def.motorSpeed = readFloat(mrb, hash, "motor_speed", def.motorSpeed);
+      def.maxMotorForce = readFloat(mrb, hash, "max_motor_force", def.maxMotorForce);
+      def.collideConnected = collideConnected;
+      joint = world->CreateJoint(&def);
+      break;
+    }
+    case WELD_JOINT:
+    {
+      b2WeldJointDef def;
+      def.Initialize(bodyA, bodyB, anchor);
+      def.frequencyHz = readFloat(mrb, hash, "frequency", def.frequencyHz);
+      def.dampingRatio = readFloat(mrb, hash, "damping_ratio", def.dampingRatio);
+      def.collideConnected = collideConnected;
+      joint = world->CreateJoint(&def);
+      break;
+    }
+    case WHEEL_JOINT:
+    {
+      b2WheelJointDef def;
+      def.Initialize(bodyA, bodyB, anchor, axis);
+      def.enableMotor = readBool(mrb, hash, "enable_motor", def.enableMotor);
+      def.motorSpeed = readFloat(mrb, hash, "motor_speed", def.motorSpeed);
+      def.maxMotorTorque = readFloat(mrb, hash, "max_motor_torque", def.maxMotorTorque);
+      def.frequencyHz = readFloat(mrb, hash, "frequency", def.frequencyHz);
+      def.dampingRatio = readFloat(mrb, hash, "damping_ratio", def.dampingRatio);
+      def.collideConnected = collideConnected;
+      joint = world->CreateJoint(&def);
+      break;
+    }
+    case ROPE_JOINT:
+    {
+      b2RopeJointDef def;
+      def.bodyA = bodyA;
+      def.bodyB = bodyB;
+      def.localAnchorA = bodyA->GetLocalPoint(readVector(mrb, hash, "anchor_a", bodyA->GetWorldCenter()));
+      def.localAnchorB = bodyB->GetLocalPoint(readVector(mrb, hash, "anchor_b", bodyB->GetWorldCenter()));
+      def.maxLength = readFloat(mrb, hash, "max_length", def.maxLength);
+      def.collideConnected = collideConnected;
+      joint = world->CreateJoint(&def);
+      break;
+    }
+  }
+
+  joint->SetUserData(this);
+}
+
+b2Joint* Joint::getJoint()
+{
+  return joint;
+}
+
+static mrb_value Joint_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_raise(mrb, E_RUNTIME_ERROR, "Wrong use of this class. Try RubyAction::Physics::World.create_joint");
+  return self;
+}
+
+static mrb_value Joint_getBodyA(mrb_state *mrb, mrb_value self)
+{
+  return unwrap<Joint>(self)->getProperty("body_a");
+}
+
+static mrb_value Joint_getBodyB(mrb_state *mrb, mrb_value self)
+{
+  return unwrap<Joint>(self)->getProperty("body_b");
+}
+
+// Unwraps a joint to read its impulses from, once its world is not being stepped on a stepper thread.
+static b2Joint* settled(mrb_value self)
+{
+  b2Joint *joint = unwrap<Joint>(self)->getJoint();
+  World::sync(joint->GetBodyA()->GetWorld());
+  return joint;
+}
+
+static mrb_value Joint_getReactionForce(mrb_state *mrb, mrb_value self)
+{
+  mrb_float invDt;
+  mrb_get_args(mrb, "f", &invDt);
+
+  b2Vec2 force = settled(self)->GetReactionForce(invDt);
+  mrb_value values[2] = { mrb_float_value(mrb, force.x), mrb_float_value(mrb, force.y) };
+  return mrb_ary_new_from_values(mrb, 2, values);
+}
+
+static mrb_value Joint_getReactionTorque(mrb_state *mrb, mrb_value self)
+{
+  mrb_float invDt;
+  mrb_get_args(mrb, "f", &invDt);
+  return mrb_float_value(mrb, settled(self)->GetReactionTorque(invDt));
+}
+
+void Physics::bindJoint(mrb_state *mrb, RClass *module, RClass *physics)
+{
+  struct RClass *clazz = mrb_define_class_under(mrb, physics, "Joint", mrb->object_class);
+  MRB_SET_INSTANCE_TT(clazz, MRB_TT_DATA);
+
+  mrb_define_method(mrb, clazz, "initialize", Joint_initialize, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "body_a", Joint_getBodyA, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "body_b", Joint_getBodyB, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "reaction_force", Joint_getReactionForce, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "reaction_torque", Joint_getReactionTorque, MRB_ARGS_REQ(1));
+
+  mrb_define_const(mrb, clazz, "DISTANCE", mrb_fixnum_value(DISTANCE_JOINT));
+  mrb_define_const(mrb, clazz, "REVOLUTE", mrb_fixnum_value(REVOLUTE_JOINT));
+  mrb_define_const(mrb, clazz, "PRISMATIC", mrb_fixnum_value(PRISMATIC_JOINT));
+  mrb_define_const(mrb, clazz, "WELD", mrb_fixnum_value(WELD_JOINT));
+  mrb_define_const(mrb, clazz, "WHEEL", mrb_fixnum_value(WHEEL_JOINT));
+  mrb_define_const(mrb, clazz, "ROPE", mrb_fixnum_value(ROPE_JOINT));
+}
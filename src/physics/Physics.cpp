@@ -1,6 +1,8 @@
 #include "physics/Physics.hpp"
 #include "physics/World.hpp"
 #include "physics/Body.hpp"
+#include "physics/Fixture.hpp"
+#include "physics/Joint.hpp"
 
 using namespace RubyAction;
 
@@ -9,4 +11,6 @@ void Physics::bind(mrb_state *mrb, RClass *module)
   struct RClass *physics = mrb_define_module_under(mrb, module, "Physics");
   bindWorld(mrb, module, physics);
   bindBody(mrb, module, physics);
+  bindFixture(mrb, module, physics);
+  bindJoint(mrb, module, physics);
 }
@@ -1,19 +1,48 @@
 #include "physics/World.hpp"
+#include "util/array.hpp"
+#include "util/hash.hpp"
 #include <mruby/array.h>
+#include <mruby/hash.h>
+#include <mruby/string.h>
+#include <Box2D/Common/b2ThreadPool.h>
+#include <algorithm>
+#include <cmath>
 
 using namespace RubyAction;
 using namespace RubyAction::Physics;
 
-World::World(mrb_value self, int gravityx, int gravityy, bool doSleep)
-  : EventDispatcher(self)
+std::vector<World*> World::pipelinedWorlds;
+
+World::World(mrb_value self, int gravityx, int gravityy, bool doSleep, int threads)
+  : EventDispatcher(self),
+    pixelsPerMeter(1),
+    fixedTimeStep(1.0f / 60),
+    fixedVelocityIterations(8),
+    fixedPositionIterations(3),
+    maxSubsteps(5),
+    accumulator(0),
+    stepTimes(600),
+    debugDraw(NULL),
+    pendingSteps(0),
+    stepping(false),
+    stopping(false),
+    pendingAlpha(0),
+    begunContactsSorted(true)
 {
+  setProperty("bodies", mrb_ary_new(mrb));
+  setProperty("joints", mrb_ary_new(mrb));
+
   b2Vec2 gravity(gravityx, gravityy);
   this->world = new b2World(gravity);
   this->world->SetAllowSleeping(doSleep);
+  this->world->SetContactListener(this);
+  this->world->SetThreadCount(threads);
 }
 
 World::~World()
 {
+  stopStepper();
+  delete this->debugDraw;
   delete this->world;
 }
 
@@ -22,9 +51,87 @@ void World::clearForces()
   this->world->ClearForces();
 }
 
+// Checks the fixture hashes before any FixtureDefs exist, as nothing may raise past them.
+static void checkFixtureDefs(mrb_state *mrb, mrb_value hash)
+{
+  mrb_value fixtures = H_GET_VALUE(hash, "fixtures");
+  if (mrb_nil_p(fixtures)) return;
+  if (!mrb_array_p(fixtures)) mrb_raise(mrb, E_TYPE_ERROR, "expected an Array of fixtures");
+
+  for (int i = 0; i < A_SIZE(fixtures); i++)
+  {
+    FixtureDef::check(mrb, A_GET_VALUE(fixtures, i));
+  }
+}
+
+void World::readFixtureDefs(mrb_value hash, FixtureDefs& defs)
+{
+  mrb_value fixtures = H_GET_VALUE(hash, "fixtures");
+  if (mrb_nil_p(fixtures)) return;
+
+  for (int i = 0; i < A_SIZE(fixtures); i++)
+  {
+    defs.push_back(std::unique_ptr<FixtureDef>(new FixtureDef(mrb, A_GET_VALUE(fixtures, i))));
+  }
+}
+
+Body* World::createBody(const b2BodyDef& def, const FixtureDefs& fixtures)
+{
+  Body *body = new Body(this->world, def);
+  mrb_ary_push(mrb, getProperty("bodies"), body->getSelf());
+
+  for (FixtureDefs::const_iterator fixture = fixtures.begin(); fixture != fixtures.end(); ++fixture)
+  {
+    int arena = mrb_gc_arena_save(mrb);
+    body->createFixture(**fixture);
+    mrb_gc_arena_restore(mrb, arena);
+  }
+  return body;
+}
+
 Body* World::createBody(mrb_value hash)
 {
-  return new Body(this->world, hash);
+  b2BodyDef def;
+  Body::readDef(mrb, hash, &def);
+  checkFixtureDefs(mrb, hash);
+  FixtureDefs fixtures;
+  readFixtureDefs(hash, fixtures);
+  return createBody(def, fixtures);
+}
+
+// Creates one body per [x, y, angle] triple in the packed placements array, all sharing the
+// body and fixture definitions, which are read from the hash only once.
+mrb_value World::createBodies(mrb_value hash, mrb_value placements)
+{
+  b2BodyDef def;
+  Body::readDef(mrb, hash, &def);
+  checkFixtureDefs(mrb, hash);
+  int count = A_SIZE(placements) / 3;
+  for (int i = 0; i < count * 3; i++)
+  {
+    (void) A_GET_FLOAT(placements, i);
+  }
+
+  FixtureDefs fixtures;
+  readFixtureDefs(hash, fixtures);
+  mrb_value bodies = mrb_ary_new_capa(mrb, count);
+  for (int i = 0; i < count; i++)
+  {
+    int arena = mrb_gc_arena_save(mrb);
+    def.position.Set(A_GET_FLOAT(placements, i * 3), A_GET_FLOAT(placements, i * 3 + 1));
+    def.angle = A_GET_FLOAT(placements, i * 3 + 2);
+    mrb_ary_push(mrb, bodies, createBody(def, fixtures)->getSelf());
+    mrb_gc_arena_restore(mrb, arena);
+  }
+  return bodies;
+}
+
+Joint* World::createJoint(mrb_value hash)
+{
+  Joint::check(mrb, this->world, hash);
+  Joint *joint = new Joint(this->world, hash);
+  mrb_ary_push(mrb, getProperty("joints"), joint->getSelf());
+  return joint;
 }
 
 int* World::getGravity()
@@ -45,29 +152,605 @@ void World::raycast(int x1, int y1, int x2, int y2, mrb_value callback)
   this->raycastCallback = mrb_nil_value();
 }
 
-void World::step(float timeStep, int velocityIterations, int positionIterations)
+// Casts one ray per [x1, y1, x2, y2] quadruple in the packed rays array and returns the closest hit of each
+// as a packed [fixture, x, y, normal x, normal y, fraction] sextuple, fixture being nil on a miss.
+mrb_value World::raycastClosest(mrb_value rays)
+{
+  int count = A_SIZE(rays) / 4;
+  std::vector<b2Vec2> points(count * 2);
+  for (int i = 0; i < count * 2; i++)
+  {
+    points[i].Set(A_GET_FLOAT(rays, i * 2), A_GET_FLOAT(rays, i * 2 + 1));
+  }
+
+  std::vector<b2RayCastHit> hits(count);
+  this->world->RayCastClosest(hits.data(), points.data(), count);
+
+  mrb_value results = mrb_ary_new_capa(mrb, count * 6);
+  for (int i = 0; i < count; i++)
+  {
+    const b2RayCastHit& hit = hits[i];
+    mrb_ary_push(mrb, results, hit.fixture ? ((Fixture*) hit.fixture->GetUserData())->getSelf() : mrb_nil_value());
+    mrb_ary_push(mrb, results, mrb_float_value(mrb, hit.point.x));
+    mrb_ary_push(mrb, results, mrb_float_value(mrb, hit.point.y));
+    mrb_ary_push(mrb, results, mrb_float_value(mrb, hit.normal.x));
+    mrb_ary_push(mrb, results, mrb_float_value(mrb, hit.normal.y));
+    mrb_ary_push(mrb, results, mrb_float_value(mrb, hit.fraction));
+  }
+  return results;
+}
+
+// Queries one box per [lower x, lower y, upper x, upper y] quadruple in the packed boxes array and returns,
+// for each box, the array of fixtures whose bounding boxes overlap it.
+mrb_value World::queryAABBs(mrb_value boxes)
 {
+  int count = A_SIZE(boxes) / 4;
+  std::vector<b2AABB> aabbs(count);
+  for (int i = 0; i < count; i++)
+  {
+    aabbs[i].lowerBound.Set(A_GET_FLOAT(boxes, i * 4), A_GET_FLOAT(boxes, i * 4 + 1));
+    aabbs[i].upperBound.Set(A_GET_FLOAT(boxes, i * 4 + 2), A_GET_FLOAT(boxes, i * 4 + 3));
+  }
+
+  std::vector<QueryCollector> collectors(count);
+  std::vector<b2QueryCallback*> callbacks(count);
+  for (int i = 0; i < count; i++)
+  {
+    callbacks[i] = &collectors[i];
+  }
+  this->world->QueryAABB(callbacks.data(), aabbs.data(), count);
+
+  mrb_value results = mrb_ary_new_capa(mrb, count);
+  for (int i = 0; i < count; i++)
+  {
+    int arena = mrb_gc_arena_save(mrb);
+    const std::vector<b2Fixture*>& fixtures = collectors[i].fixtures;
+    mrb_value found = mrb_ary_new_capa(mrb, fixtures.size());
+    for (size_t j = 0; j < fixtures.size(); j++)
+    {
+      mrb_ary_push(mrb, found, ((Fixture*) fixtures[j]->GetUserData())->getSelf());
+    }
+    mrb_ary_push(mrb, results, found);
+    mrb_gc_arena_restore(mrb, arena);
+  }
+  return results;
+}
+
+void World::saveTransforms()
+{
+  for (b2Body *body = this->world->GetBodyList(); body; body = body->GetNext())
+  {
+    ((Body*) body->GetUserData())->saveTransform();
+  }
+}
+
+// Takes one step without touching Ruby, contacts being buffered for deliverContacts.
+void World::simulate(float timeStep, int velocityIterations, int positionIterations)
+{
+  saveTransforms();
   this->world->Step(timeStep, velocityIterations, positionIterations);
-  this->world->DrawDebugData();
+  stepTimes.add(this->world->GetProfile().step);
+}
+
+void World::step(float timeStep, int velocityIterations, int positionIterations)
+{
+  simulate(timeStep, velocityIterations, positionIterations);
+  syncSprites(1);
+  deliverContacts();
+}
+
+struct StepAllContext
+{
+  World* const* worlds;
+  float timeStep;
+  int velocityIterations;
+  int positionIterations;
+};
+
+void World::simulateTask(void* context, int32 index, int32 worker)
+{
+  B2_NOT_USED(worker);
+  StepAllContext* stepAll = (StepAllContext*) context;
+  stepAll->worlds[index]->simulate(stepAll->timeStep, stepAll->velocityIterations, stepAll->positionIterations);
+}
+
+// Steps independent worlds in parallel, one per thread of a pool sized to the machine, then syncs their sprites
+// and delivers their contacts on the calling thread, world after world.
+void World::stepAll(const std::vector<World*>& worlds, float timeStep, int velocityIterations, int positionIterations)
+{
+  static b2ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+
+  StepAllContext context = { worlds.data(), timeStep, velocityIterations, positionIterations };
+  pool.ParallelFor(worlds.size(), simulateTask, &context);
+
+  for (size_t i = 0; i < worlds.size(); i++)
+  {
+    worlds[i]->syncSprites(1);
+    worlds[i]->deliverContacts();
+  }
+}
+
+void World::setFixedStep(float timeStep, int velocityIterations, int positionIterations, int maxSubsteps)
+{
+  this->fixedTimeStep = timeStep;
+  this->fixedVelocityIterations = velocityIterations;
+  this->fixedPositionIterations = positionIterations;
+  this->maxSubsteps = maxSubsteps;
+}
+
+// Adds the frame time to the accumulator and consumes it in fixed steps, at most maxSubsteps of them, then
+// syncs sprites between the last two steps by the fraction of a step left over.
+int World::advance(float delta)
+{
+  if (stepper.joinable()) return advancePipelined(delta);
+
+  accumulator += delta;
+  int steps = std::min((int) (accumulator / fixedTimeStep), maxSubsteps);
+
+  for (int i = 0; i < steps; i++)
+  {
+    // only the transforms before the last step are interpolated from
+    if (i == steps - 1) saveTransforms();
+    this->world->Step(fixedTimeStep, fixedVelocityIterations, fixedPositionIterations);
+    stepTimes.add(this->world->GetProfile().step);
+    accumulator -= fixedTimeStep;
+    deliverContacts();
+  }
+
+  // a hitch longer than maxSubsteps steps is dropped instead of being caught up on over the next frames
+  if (accumulator >= fixedTimeStep) accumulator = std::fmod(accumulator, fixedTimeStep);
+
+  syncSprites(getAlpha());
+  return steps;
+}
+
+// Shows the steps started by the previous frame, then starts this frame's steps on the stepper thread, where
+// they run while the frame is scripted and rendered. Sprites, the debug draw and contact events are all a frame
+// behind the simulation; the sprites keep the transforms the frame is rendered from while the bodies move on.
+int World::advancePipelined(float delta)
+{
+  sync();
+  syncSprites(pendingAlpha);
+  if (debugDraw) debugDraw->collect();
+  deliverContacts();
+
+  accumulator += delta;
+  int steps = std::min((int) (accumulator / fixedTimeStep), maxSubsteps);
+  accumulator -= steps * fixedTimeStep;
+  if (accumulator >= fixedTimeStep) accumulator = std::fmod(accumulator, fixedTimeStep);
+  pendingAlpha = getAlpha();
+  if (!steps) return 0;
+
+  // a contact listener may have started steps of its own
+  sync();
+  std::lock_guard<std::mutex> lock(stepMutex);
+  pendingSteps = steps;
+  stepping = true;
+  stepWake.notify_one();
+  return steps;
+}
+
+// Runs on the stepper thread. Contacts are only buffered, for advancePipelined to deliver at the next frame.
+void World::runSteps(int steps)
+{
+  for (int i = 0; i < steps; i++)
+  {
+    if (i == steps - 1) saveTransforms();
+    this->world->Step(fixedTimeStep, fixedVelocityIterations, fixedPositionIterations);
+    stepTimes.add(this->world->GetProfile().step);
+
+    // impulses are only recorded in the step a contact began in
+    begunContacts.clear();
+    begunContactsSorted = true;
+  }
+}
+
+void World::runStepper()
+{
+  std::unique_lock<std::mutex> lock(stepMutex);
+  while (true)
+  {
+    stepWake.wait(lock, [this] { return stepping || stopping; });
+    if (stopping) return;
+
+    lock.unlock();
+    runSteps(pendingSteps);
+    lock.lock();
+    stepping = false;
+    stepDone.notify_all();
+  }
+}
+
+bool World::isPipelined()
+{
+  return stepper.joinable();
+}
+
+void World::stopStepper()
+{
+  if (!stepper.joinable()) return;
+
+  sync();
+  {
+    std::lock_guard<std::mutex> lock(stepMutex);
+    stopping = true;
+    stepWake.notify_one();
+  }
+  stepper.join();
+  pipelinedWorlds.erase(std::find(pipelinedWorlds.begin(), pipelinedWorlds.end(), this));
+}
+
+// Starts or stops the stepper thread. Stopping shows whatever it was stepping, like the next advance would.
+void World::setPipelined(bool pipelined)
+{
+  if (pipelined == stepper.joinable()) return;
+
+  if (pipelined)
+  {
+    stopping = false;
+    stepper = std::thread(&World::runStepper, this);
+    pipelinedWorlds.push_back(this);
+  }
+  else
+  {
+    stopStepper();
+    syncSprites(pendingAlpha);
+  }
+  if (debugDraw) debugDraw->setPipelined(pipelined);
+}
+
+// Waits for the stepper thread to finish its steps. Everything that reads or changes the b2World from the
+// main thread goes through here first.
+void World::sync()
+{
+  if (!stepper.joinable()) return;
+  std::unique_lock<std::mutex> lock(stepMutex);
+  stepDone.wait(lock, [this] { return !stepping; });
+}
+
+// For bodies, fixtures and joints, which only know their b2World.
+void World::sync(b2World* world)
+{
+  for (std::vector<World*>::iterator other = pipelinedWorlds.begin(); other != pipelinedWorlds.end(); ++other)
+  {
+    if ((*other)->world == world) (*other)->sync();
+  }
+}
+
+float World::getAlpha()
+{
+  return accumulator / fixedTimeStep;
+}
+
+// Returns the timings, in milliseconds, of the last step.
+mrb_value World::getProfile()
+{
+  const b2Profile& profile = this->world->GetProfile();
+  mrb_value hash = mrb_hash_new(mrb);
+  H_SET_VALUE(hash, "step", mrb_float_value(mrb, profile.step));
+  H_SET_VALUE(hash, "collide", mrb_float_value(mrb, profile.collide));
+  H_SET_VALUE(hash, "solve", mrb_float_value(mrb, profile.solve));
+  H_SET_VALUE(hash, "solve_init", mrb_float_value(mrb, profile.solveInit));
+  H_SET_VALUE(hash, "solve_velocity", mrb_float_value(mrb, profile.solveVelocity));
+  H_SET_VALUE(hash, "solve_position", mrb_float_value(mrb, profile.solvePosition));
+  H_SET_VALUE(hash, "broadphase", mrb_float_value(mrb, profile.broadphase));
+  H_SET_VALUE(hash, "solve_toi", mrb_float_value(mrb, profile.solveTOI));
+  return hash;
+}
+
+mrb_value World::getStats()
+{
+  int awakeBodies = 0;
+  for (b2Body *body = this->world->GetBodyList(); body; body = body->GetNext())
+  {
+    if (body->IsAwake() && body->GetType() != b2_staticBody) awakeBodies++;
+  }
+
+  int touchingContacts = 0;
+  for (b2Contact *contact = this->world->GetContactList(); contact; contact = contact->GetNext())
+  {
+    if (contact->IsTouching()) touchingContacts++;
+  }
+
+  mrb_value hash = mrb_hash_new(mrb);
+  H_SET_VALUE(hash, "bodies", mrb_fixnum_value(this->world->GetBodyCount()));
+  H_SET_VALUE(hash, "awake_bodies", mrb_fixnum_value(awakeBodies));
+  H_SET_VALUE(hash, "joints", mrb_fixnum_value(this->world->GetJointCount()));
+  H_SET_VALUE(hash, "contacts", mrb_fixnum_value(this->world->GetContactCount()));
+  H_SET_VALUE(hash, "touching_contacts", mrb_fixnum_value(touchingContacts));
+  H_SET_VALUE(hash, "proxies", mrb_fixnum_value(this->world->GetProxyCount()));
+  H_SET_VALUE(hash, "islands", mrb_fixnum_value(this->world->GetIslandCount()));
+  H_SET_VALUE(hash, "tree_height", mrb_fixnum_value(this->world->GetTreeHeight()));
+  H_SET_VALUE(hash, "tree_balance", mrb_fixnum_value(this->world->GetTreeBalance()));
+  H_SET_VALUE(hash, "tree_quality", mrb_float_value(mrb, this->world->GetTreeQuality()));
+  return hash;
+}
+
+mrb_value World::getStepHistogram()
+{
+  return stepTimes.toHash(mrb);
+}
+
+mrb_value World::getAllocatorStats()
+{
+  b2AllocatorStats stats;
+  this->world->GetAllocatorStats(&stats);
+
+  mrb_value hash = mrb_hash_new(mrb);
+  H_SET_VALUE(hash, "stack_capacity", mrb_fixnum_value(stats.stackCapacity));
+  H_SET_VALUE(hash, "stack_high_water", mrb_fixnum_value(stats.stackMaxAllocation));
+  H_SET_VALUE(hash, "stack_fallbacks", mrb_fixnum_value(stats.stackFallbacks));
+  H_SET_VALUE(hash, "chunks", mrb_fixnum_value(stats.chunkCount));
+  H_SET_VALUE(hash, "chunk_bytes", mrb_fixnum_value(stats.chunkCount * b2_chunkSize));
+  H_SET_VALUE(hash, "blocks", mrb_fixnum_value(stats.blockCount));
+  H_SET_VALUE(hash, "large_allocations", mrb_fixnum_value(stats.largeAllocations));
+  return hash;
+}
+
+void World::reserveStack(int size)
+{
+  this->world->ReserveStack(size);
+}
+
+int World::getDebugDraw()
+{
+  return debugDraw ? debugDraw->GetFlags() : 0;
+}
+
+// Installs a debug draw for the given flags, or removes it when there are none so the world is not drawn at all.
+void World::setDebugDraw(int flags)
+{
+  if (!flags)
+  {
+    this->world->SetDebugDraw(NULL);
+    delete debugDraw;
+    debugDraw = NULL;
+    return;
+  }
+
+  if (!debugDraw)
+  {
+    debugDraw = new DebugDraw(this->world);
+    debugDraw->setScale(pixelsPerMeter);
+    debugDraw->setPipelined(isPipelined());
+    this->world->SetDebugDraw(debugDraw);
+  }
+  debugDraw->SetFlags(flags);
+}
+
+mrb_value World::snapshot()
+{
+  snapshotBuffer.resize(this->world->GetSnapshotSize());
+  this->world->SaveSnapshot(snapshotBuffer.data());
+  return mrb_str_new(mrb, snapshotBuffer.data(), snapshotBuffer.size());
+}
+
+// Puts the world back the way it was when the snapshot was taken. Bound sprites follow, with nothing left to
+// interpolate from.
+bool World::restore(const char* snapshot, size_t size)
+{
+  if (!this->world->RestoreSnapshot(snapshot, size)) return false;
+
+  saveTransforms();
+  syncSprites(1);
+  return true;
+}
+
+float World::getPixelsPerMeter()
+{
+  return pixelsPerMeter;
+}
+
+void World::setPixelsPerMeter(float pixelsPerMeter)
+{
+  this->pixelsPerMeter = pixelsPerMeter;
+  if (debugDraw) debugDraw->setScale(pixelsPerMeter);
+}
+
+int World::getThreads()
+{
+  return this->world->GetThreadCount();
+}
+
+void World::setThreads(int threads)
+{
+  this->world->SetThreadCount(threads);
+}
+
+bool World::isSimd()
+{
+  return this->world->GetSimdSolving();
+}
+
+void World::setSimd(bool simd)
+{
+  this->world->SetSimdSolving(simd);
+}
+
+int World::getPairMode()
+{
+  return this->world->GetPairMode();
+}
+
+void World::setPairMode(int mode)
+{
+  this->world->SetPairMode((b2BroadPhase::PairMode) mode);
+}
+
+bool World::isCompactTree()
+{
+  return this->world->GetTreeCompaction();
+}
+
+void World::setCompactTree(bool compact)
+{
+  this->world->SetTreeCompaction(compact);
+}
+
+void World::syncSprites(float alpha)
+{
+  for (b2Body *body = this->world->GetBodyList(); body; body = body->GetNext())
+  {
+    ((Body*) body->GetUserData())->syncSprite(alpha, pixelsPerMeter);
+  }
+}
+
+// Contacts are only recorded while b2World::Step runs; Ruby sees them in deliverContacts once it returns.
+void World::bufferContact(b2Contact* contact, bool begin)
+{
+  b2WorldManifold manifold;
+  manifold.normal.SetZero();
+  manifold.points[0].SetZero();
+  contact->GetWorldManifold(&manifold);
+
+  Contact buffered = {
+    begin,
+    (Body*) contact->GetFixtureA()->GetBody()->GetUserData(),
+    (Body*) contact->GetFixtureB()->GetBody()->GetUserData(),
+    (Fixture*) contact->GetFixtureA()->GetUserData(),
+    (Fixture*) contact->GetFixtureB()->GetUserData(),
+    manifold.normal,
+    manifold.points[0],
+    0
+  };
+
+  if (begin)
+  {
+    begunContacts.push_back(std::make_pair(contact, contacts.size()));
+    begunContactsSorted = false;
+  }
+  contacts.push_back(buffered);
 }
 
 void World::BeginContact(b2Contact* contact)
 {
-  mrb_value data[] = { mrb_fixnum_value(1), mrb_fixnum_value(2) };
-  this->dispatch(mrb_intern(mrb, "begin_contact"), data, 2);
+  bufferContact(contact, true);
 }
 
 void World::EndContact(b2Contact* contact)
 {
-  mrb_value data[] = { mrb_fixnum_value(1), mrb_fixnum_value(2) };
-  this->dispatch(mrb_intern(mrb, "end_contact"), data, 2);
+  bufferContact(contact, false);
+}
+
+// Records the impulse of contacts that began during this step. Contacts are created during
+// the collide phase, so the lookup table is normally sorted once per step.
+void World::PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
+{
+  if (begunContacts.empty()) return;
+
+  if (!begunContactsSorted)
+  {
+    std::sort(begunContacts.begin(), begunContacts.end());
+    begunContactsSorted = true;
+  }
+
+  // a destroyed contact's address may be reused within the step, the latest one wins
+  std::vector<std::pair<b2Contact*, size_t> >::iterator begun = std::upper_bound(begunContacts.begin(),
+    begunContacts.end(), std::make_pair(contact, contacts.size()));
+  if (begun == begunContacts.begin() || (--begun)->first != contact) return;
+
+  float32 total = 0;
+  for (int32 i = 0; i < impulse->count; i++) total += impulse->normalImpulses[i];
+  contacts[begun->second].impulse = b2Max(contacts[begun->second].impulse, total);
+}
+
+// Delivers the buffered contacts as a single :contacts event on the world, then as
+// :begin_contact/:end_contact on the world and on both bodies, to whichever has a listener.
+void World::deliverContacts()
+{
+  begunContacts.clear();
+  begunContactsSorted = true;
+  if (contacts.empty()) return;
+
+  // listeners may step the world again, so deliver from a second buffer
+  std::vector<Contact> delivering;
+  delivering.swap(contacts);
+
+  mrb_sym contactsEvent = mrb_intern(mrb, "contacts");
+  mrb_sym beginEvent = mrb_intern(mrb, "begin_contact");
+  mrb_sym endEvent = mrb_intern(mrb, "end_contact");
+  mrb_sym beginType = mrb_intern(mrb, "begin");
+  mrb_sym endType = mrb_intern(mrb, "end");
+
+  if (hasListener(contactsEvent))
+  {
+    mrb_value events = mrb_ary_new_capa(mrb, delivering.size());
+    for (std::vector<Contact>::iterator contact = delivering.begin(); contact != delivering.end(); ++contact)
+    {
+      int arena = mrb_gc_arena_save(mrb);
+      mrb_value event[] = {
+        mrb_symbol_value(contact->begin ? beginType : endType),
+        contact->bodyA->getSelf(),
+        contact->bodyB->getSelf(),
+        mrb_float_value(mrb, contact->normal.x),
+        mrb_float_value(mrb, contact->normal.y),
+        mrb_float_value(mrb, contact->point.x),
+        mrb_float_value(mrb, contact->point.y),
+        mrb_float_value(mrb, contact->impulse),
+        contact->fixtureA->getSelf(),
+        contact->fixtureB->getSelf()
+      };
+      mrb_ary_push(mrb, events, mrb_ary_new_from_values(mrb, 10, event));
+      mrb_gc_arena_restore(mrb, arena);
+    }
+    dispatch(contactsEvent, &events, 1);
+  }
+
+  bool worldListens = hasListener(beginEvent) || hasListener(endEvent);
+  for (std::vector<Contact>::iterator contact = delivering.begin(); contact != delivering.end(); ++contact)
+  {
+    mrb_sym name = contact->begin ? beginEvent : endEvent;
+    bool aListens = contact->bodyA->hasListener(name);
+    bool bListens = contact->bodyB->hasListener(name);
+    if (!worldListens && !aListens && !bListens) continue;
+
+    int arena = mrb_gc_arena_save(mrb);
+    mrb_value normalX = mrb_float_value(mrb, contact->normal.x);
+    mrb_value normalY = mrb_float_value(mrb, contact->normal.y);
+    mrb_value pointX = mrb_float_value(mrb, contact->point.x);
+    mrb_value pointY = mrb_float_value(mrb, contact->point.y);
+    mrb_value impulse = mrb_float_value(mrb, contact->impulse);
+
+    if (worldListens)
+    {
+      mrb_value data[] = {
+        contact->bodyA->getSelf(), contact->bodyB->getSelf(), normalX, normalY, pointX, pointY, impulse,
+        contact->fixtureA->getSelf(), contact->fixtureB->getSelf()
+      };
+      dispatch(name, data, 9);
+    }
+    if (aListens)
+    {
+      mrb_value data[] = {
+        contact->bodyB->getSelf(), normalX, normalY, pointX, pointY, impulse,
+        contact->fixtureA->getSelf(), contact->fixtureB->getSelf()
+      };
+      contact->bodyA->dispatch(name, data, 8);
+    }
+    if (bListens)
+    {
+      mrb_value data[] = {
+        contact->bodyA->getSelf(), normalX, normalY, pointX, pointY, impulse,
+        contact->fixtureB->getSelf(), contact->fixtureA->getSelf()
+      };
+      contact->bodyB->dispatch(name, data, 8);
+    }
+    mrb_gc_arena_restore(mrb, arena);
+  }
+
+  // hand the storage back so the steady state doesn't allocate
+  if (contacts.empty())
+  {
+    delivering.clear();
+    contacts.swap(delivering);
+  }
 }
 
 float32 World::ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float32 fraction)
 {
   int argc = 6;
   mrb_value argv[] = {
-    mrb_fixnum_value(182), // TODO: pass fixture object
+    ((Fixture*) fixture->GetUserData())->getSelf(),
     mrb_fixnum_value(point.x),
     mrb_fixnum_value(point.y),
     mrb_fixnum_value(normal.x),
@@ -78,22 +761,33 @@ float32 World::ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Ve
   return mrb_float(report);
 }
 
+// Unwraps a world once it is not being stepped on its stepper thread.
+static World* synced(mrb_value self)
+{
+  World* world = unwrap<World>(self);
+  world->sync();
+  return world;
+}
+
 static mrb_value World_initialize(mrb_state *mrb, mrb_value self)
 {
   mrb_int gravityx;
   mrb_int gravityy;
   mrb_bool doSleep;
-  int argc = mrb_get_args(mrb, "ii|b", &gravityx, &gravityy, &doSleep);
+  mrb_int threads;
+  int argc = mrb_get_args(mrb, "ii|bi", &gravityx, &gravityy, &doSleep, &threads);
 
-  if (argc == 2) doSleep = true;
+  if (argc < 3) doSleep = true;
+  if (argc < 4) threads = 1;
+  if (threads < 1) mrb_raise(mrb, E_ARGUMENT_ERROR, "threads must be positive");
 
-  wrap(self, new World(self, gravityx, gravityy, doSleep));
+  wrap(self, new World(self, gravityx, gravityy, doSleep, threads));
   return self;
 }
 
 static mrb_value World_clearForces(mrb_state *mrb, mrb_value self)
 {
-  unwrap<World>(self)->clearForces();
+  synced(self)->clearForces();
   return self;
 }
 
@@ -101,12 +795,27 @@ static mrb_value World_createBody(mrb_state *mrb, mrb_value self)
 {
   mrb_value hash;
   int argc = mrb_get_args(mrb, "H", &hash);
-  return unwrap<World>(self)->createBody(hash)->getSelf();
+  return synced(self)->createBody(hash)->getSelf();
+}
+
+static mrb_value World_createBodies(mrb_state *mrb, mrb_value self)
+{
+  mrb_value hash;
+  mrb_value placements;
+  mrb_get_args(mrb, "HA", &hash, &placements);
+  return synced(self)->createBodies(hash, placements);
+}
+
+static mrb_value World_createJoint(mrb_state *mrb, mrb_value self)
+{
+  mrb_value hash;
+  mrb_get_args(mrb, "H", &hash);
+  return synced(self)->createJoint(hash)->getSelf();
 }
 
 static mrb_value World_getGravity(mrb_state *mrb, mrb_value self)
 {
-  int* xy = unwrap<World>(self)->getGravity();
+  int* xy = synced(self)->getGravity();
   mrb_value gravity[2] = { mrb_fixnum_value(xy[0]), mrb_fixnum_value(xy[1]) };
   delete[] xy;
   return mrb_ary_new_from_values(mrb, 2, gravity);
@@ -117,7 +826,7 @@ static mrb_value World_setGravity(mrb_state *mrb, mrb_value self)
   mrb_value gravity;
   mrb_get_args(mrb, "A", &gravity);
 
-  World* world = unwrap<World>(self);
+  World* world = synced(self);
   world->setGravity(mrb_fixnum(mrb_ary_ref(mrb, gravity, 0)), mrb_fixnum(mrb_ary_ref(mrb, gravity, 1)));
   return self;
 }
@@ -131,10 +840,24 @@ static mrb_value World_raycast(mrb_state *mrb, mrb_value self)
   mrb_value callback;
   mrb_get_args(mrb, "iiii&", &x1, &y1, &x2, &y2, &callback);
 
-  unwrap<World>(self)->raycast(x1, y1, x2, y2, callback);
+  synced(self)->raycast(x1, y1, x2, y2, callback);
   return self;
 }
 
+static mrb_value World_raycastClosest(mrb_state *mrb, mrb_value self)
+{
+  mrb_value rays;
+  mrb_get_args(mrb, "A", &rays);
+  return synced(self)->raycastClosest(rays);
+}
+
+static mrb_value World_queryAABBs(mrb_state *mrb, mrb_value self)
+{
+  mrb_value boxes;
+  mrb_get_args(mrb, "A", &boxes);
+  return synced(self)->queryAABBs(boxes);
+}
+
 static mrb_value World_step(mrb_state *mrb, mrb_value self)
 {
   mrb_float timeStep;
@@ -142,7 +865,215 @@ static mrb_value World_step(mrb_state *mrb, mrb_value self)
   mrb_int positionIterations;
   mrb_get_args(mrb, "fii", &timeStep, &velocityIterations, &positionIterations);
 
-  unwrap<World>(self)->step(timeStep, velocityIterations, positionIterations);
+  synced(self)->step(timeStep, velocityIterations, positionIterations);
+  return self;
+}
+
+static mrb_value World_fixedStep(mrb_state *mrb, mrb_value self)
+{
+  mrb_float timeStep;
+  mrb_int velocityIterations;
+  mrb_int positionIterations;
+  mrb_int maxSubsteps;
+  int argc = mrb_get_args(mrb, "f|iii", &timeStep, &velocityIterations, &positionIterations, &maxSubsteps);
+
+  if (argc < 2) velocityIterations = 8;
+  if (argc < 3) positionIterations = 3;
+  if (argc < 4) maxSubsteps = 5;
+  if (timeStep <= 0) mrb_raise(mrb, E_ARGUMENT_ERROR, "time step must be positive");
+  if (maxSubsteps < 1) mrb_raise(mrb, E_ARGUMENT_ERROR, "max substeps must be positive");
+
+  synced(self)->setFixedStep(timeStep, velocityIterations, positionIterations, maxSubsteps);
+  return self;
+}
+
+static mrb_value World_advance(mrb_state *mrb, mrb_value self)
+{
+  mrb_float delta;
+  mrb_get_args(mrb, "f", &delta);
+  return mrb_fixnum_value(unwrap<World>(self)->advance(delta));
+}
+
+static mrb_value World_getAlpha(mrb_state *mrb, mrb_value self)
+{
+  return mrb_float_value(mrb, unwrap<World>(self)->getAlpha());
+}
+
+static mrb_value World_getProfile(mrb_state *mrb, mrb_value self)
+{
+  return synced(self)->getProfile();
+}
+
+static mrb_value World_getStats(mrb_state *mrb, mrb_value self)
+{
+  return synced(self)->getStats();
+}
+
+static mrb_value World_getStepHistogram(mrb_state *mrb, mrb_value self)
+{
+  return synced(self)->getStepHistogram();
+}
+
+static mrb_value World_getAllocatorStats(mrb_state *mrb, mrb_value self)
+{
+  return synced(self)->getAllocatorStats();
+}
+
+static mrb_value World_reserveStack(mrb_state *mrb, mrb_value self)
+{
+  mrb_int size;
+  mrb_get_args(mrb, "i", &size);
+  if (size < 0) mrb_raise(mrb, E_ARGUMENT_ERROR, "size must not be negative");
+  synced(self)->reserveStack(size);
+  return self;
+}
+
+static mrb_value World_getDebugDraw(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(synced(self)->getDebugDraw());
+}
+
+static mrb_value World_setDebugDraw(mrb_state *mrb, mrb_value self)
+{
+  mrb_int flags;
+  mrb_get_args(mrb, "i", &flags);
+  const mrb_int all = b2Draw::e_shapeBit | b2Draw::e_jointBit | b2Draw::e_aabbBit | b2Draw::e_centerOfMassBit |
+    DebugDraw::e_contactBit;
+  if (flags & ~all) mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown debug draw flag");
+  synced(self)->setDebugDraw(flags);
+  return self;
+}
+
+static mrb_value World_snapshot(mrb_state *mrb, mrb_value self)
+{
+  return synced(self)->snapshot();
+}
+
+static mrb_value World_restore(mrb_state *mrb, mrb_value self)
+{
+  const char *snapshot;
+  int size;
+  mrb_get_args(mrb, "s", &snapshot, &size);
+  if (!synced(self)->restore(snapshot, size))
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "snapshot does not match this world");
+  return self;
+}
+
+static mrb_value World_getPixelsPerMeter(mrb_state *mrb, mrb_value self)
+{
+  return mrb_float_value(mrb, unwrap<World>(self)->getPixelsPerMeter());
+}
+
+static mrb_value World_setPixelsPerMeter(mrb_state *mrb, mrb_value self)
+{
+  mrb_float pixelsPerMeter;
+  mrb_get_args(mrb, "f", &pixelsPerMeter);
+  unwrap<World>(self)->setPixelsPerMeter(pixelsPerMeter);
+  return self;
+}
+
+static mrb_value World_getThreads(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(synced(self)->getThreads());
+}
+
+static mrb_value World_setThreads(mrb_state *mrb, mrb_value self)
+{
+  mrb_int threads;
+  mrb_get_args(mrb, "i", &threads);
+  if (threads < 1) mrb_raise(mrb, E_ARGUMENT_ERROR, "threads must be positive");
+  synced(self)->setThreads(threads);
+  return self;
+}
+
+static mrb_value World_isSimd(mrb_state *mrb, mrb_value self)
+{
+  return mrb_bool_value(synced(self)->isSimd());
+}
+
+static mrb_value World_setSimd(mrb_state *mrb, mrb_value self)
+{
+  mrb_bool simd;
+  mrb_get_args(mrb, "b", &simd);
+  synced(self)->setSimd(simd);
+  return self;
+}
+
+static mrb_value World_getPairMode(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(synced(self)->getPairMode());
+}
+
+static mrb_value World_setPairMode(mrb_state *mrb, mrb_value self)
+{
+  mrb_int mode;
+  mrb_get_args(mrb, "i", &mode);
+  if (mode != b2BroadPhase::e_sortedPairs && mode != b2BroadPhase::e_uniquePairs)
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown pair mode");
+  synced(self)->setPairMode(mode);
+  return self;
+}
+
+static mrb_value World_isCompactTree(mrb_state *mrb, mrb_value self)
+{
+  return mrb_bool_value(synced(self)->isCompactTree());
+}
+
+static mrb_value World_setCompactTree(mrb_state *mrb, mrb_value self)
+{
+  mrb_bool compact;
+  mrb_get_args(mrb, "b", &compact);
+  synced(self)->setCompactTree(compact);
+  return self;
+}
+
+static mrb_value World_isPipelined(mrb_state *mrb, mrb_value self)
+{
+  return mrb_bool_value(unwrap<World>(self)->isPipelined());
+}
+
+static mrb_value World_setPipelined(mrb_state *mrb, mrb_value self)
+{
+  mrb_bool pipelined;
+  mrb_get_args(mrb, "b", &pipelined);
+  unwrap<World>(self)->setPipelined(pipelined);
+  return self;
+}
+
+static mrb_value World_syncSprites(mrb_state *mrb, mrb_value self)
+{
+  mrb_float alpha;
+  mrb_get_args(mrb, "f", &alpha);
+  synced(self)->syncSprites(alpha);
+  return self;
+}
+
+static mrb_value Physics_stepAll(mrb_state *mrb, mrb_value self)
+{
+  mrb_value array;
+  mrb_float timeStep;
+  mrb_int velocityIterations;
+  mrb_int positionIterations;
+  int argc = mrb_get_args(mrb, "Af|ii", &array, &timeStep, &velocityIterations, &positionIterations);
+
+  if (argc < 3) velocityIterations = 8;
+  if (argc < 4) positionIterations = 3;
+
+  RClass *clazz = mrb_class_get_under(mrb, mrb_class_ptr(self), "World");
+  std::vector<World*> worlds(A_SIZE(array));
+  for (size_t i = 0; i < worlds.size(); i++)
+  {
+    mrb_value world = A_GET_VALUE(array, i);
+    if (!mrb_obj_is_kind_of(mrb, world, clazz)) mrb_raise(mrb, E_TYPE_ERROR, "expected World");
+    worlds[i] = synced(world);
+  }
+
+  std::vector<World*> sorted(worlds);
+  std::sort(sorted.begin(), sorted.end());
+  if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "a world can only be stepped once");
+
+  World::stepAll(worlds, timeStep, velocityIterations, positionIterations);
   return self;
 }
 
@@ -152,11 +1083,50 @@ void Physics::bindWorld(mrb_state *mrb, RClass *module, RClass *physics)
   struct RClass *clazz = mrb_define_class_under(mrb, physics, "World", super);
   MRB_SET_INSTANCE_TT(clazz, MRB_TT_DATA);
 
-  mrb_define_method(mrb, clazz, "initialize", World_initialize, MRB_ARGS_ARG(2, 1));
+  mrb_define_method(mrb, clazz, "initialize", World_initialize, MRB_ARGS_ARG(2, 2));
   mrb_define_method(mrb, clazz, "clear_forces!", World_clearForces, MRB_ARGS_NONE());
   mrb_define_method(mrb, clazz, "create_body", World_createBody, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "create_bodies", World_createBodies, MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, clazz, "create_joint", World_createJoint, MRB_ARGS_REQ(1));
   mrb_define_method(mrb, clazz, "gravity", World_getGravity, MRB_ARGS_NONE());
   mrb_define_method(mrb, clazz, "gravity=", World_setGravity, MRB_ARGS_REQ(1));
   mrb_define_method(mrb, clazz, "raycast", World_raycast, MRB_ARGS_REQ(4));
+  mrb_define_method(mrb, clazz, "raycast_closest", World_raycastClosest, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "query_aabbs", World_queryAABBs, MRB_ARGS_REQ(1));
   mrb_define_method(mrb, clazz, "step", World_step, MRB_ARGS_REQ(3));
+  mrb_define_method(mrb, clazz, "fixed_step", World_fixedStep, MRB_ARGS_ARG(1, 3));
+  mrb_define_method(mrb, clazz, "advance", World_advance, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "alpha", World_getAlpha, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "profile", World_getProfile, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "stats", World_getStats, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "step_histogram", World_getStepHistogram, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "allocator_stats", World_getAllocatorStats, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "reserve_stack", World_reserveStack, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "debug_draw", World_getDebugDraw, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "debug_draw=", World_setDebugDraw, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "snapshot", World_snapshot, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "restore", World_restore, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "pixels_per_meter", World_getPixelsPerMeter, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "pixels_per_meter=", World_setPixelsPerMeter, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "threads", World_getThreads, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "threads=", World_setThreads, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "simd?", World_isSimd, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "simd=", World_setSimd, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "pair_mode", World_getPairMode, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "pair_mode=", World_setPairMode, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "compact_tree?", World_isCompactTree, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "compact_tree=", World_setCompactTree, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "pipelined?", World_isPipelined, MRB_ARGS_NONE());
+  mrb_define_method(mrb, clazz, "pipelined=", World_setPipelined, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, clazz, "sync_sprites", World_syncSprites, MRB_ARGS_REQ(1));
+
+  mrb_define_module_function(mrb, physics, "step_all", Physics_stepAll, MRB_ARGS_ARG(2, 2));
+
+  mrb_define_const(mrb, clazz, "SORTED_PAIRS", mrb_fixnum_value(b2BroadPhase::e_sortedPairs));
+  mrb_define_const(mrb, clazz, "UNIQUE_PAIRS", mrb_fixnum_value(b2BroadPhase::e_uniquePairs));
+  mrb_define_const(mrb, clazz, "DRAW_SHAPES", mrb_fixnum_value(b2Draw::e_shapeBit));
+  mrb_define_const(mrb, clazz, "DRAW_JOINTS", mrb_fixnum_value(b2Draw::e_jointBit));
+  mrb_define_const(mrb, clazz, "DRAW_AABBS", mrb_fixnum_value(b2Draw::e_aabbBit));
+  mrb_define_const(mrb, clazz, "DRAW_CENTERS", mrb_fixnum_value(b2Draw::e_centerOfMassBit));
+  mrb_define_const(mrb, clazz, "DRAW_CONTACTS", mrb_fixnum_value(DebugDraw::e_contactBit));
 }